@@ -0,0 +1,324 @@
+#include "santorini.h"
+
+using namespace std;
+using namespace santorini::detail;
+
+// Benchmarks for the move generator, the players and MonteCarlo.
+//
+// Every line of output is "name value", so runs can be compared with diff or
+// a script. The perft counts double as a check on get_legal_plays, and the
+// random walks check the board's other invariants: the program exits with
+// status 1 if the counts from the start position don't match the known
+// ones, if any walk finds a state that breaks an invariant, or if
+// unpack_state accepts a key that no valid board packs to.
+
+// Perft counts from get_start_state(), by depth.
+const vector<int64_t> START_PERFT = {1, 36, 1296, 69468, 3572700, 208565860};
+
+// The number of states depth plies from state, counting states where the
+// game is over as leaves. Plays are made and taken back on state in place.
+int64_t perft(State *state, int depth) {
+  Plays plays = get_legal_plays(*state);
+  if (depth == 1) {
+    return plays.size();
+  }
+  int64_t count = 0;
+  for (const Play &play : plays) {
+    Undo undo = make_play(state, play);
+    count += get_winner_after(*state, play) >= 0 ? 1 : perft(state, depth - 1);
+    unmake_play(state, play, undo);
+  }
+  return count;
+}
+
+int64_t perft(const State &state, int depth) {
+  if (!depth || get_winner(state) >= 0) {
+    return 1;
+  }
+  State board(state);
+  return perft(&board, depth);
+}
+
+double seconds_since(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Checks the perft counts from the start position, and reports them for a
+// sample of the starting positions too.
+bool bench_perft(int depth, int samples) {
+  bool ok = true;
+  for (int d = 1; d <= depth; ++d) {
+    auto start = chrono::steady_clock::now();
+    int64_t count = perft(get_start_state(), d);
+    double seconds = seconds_since(start);
+    printf("perft.start.%d %lld\n", d, static_cast<long long>(count));
+    printf("perft.start.%d.states_per_second %.0f\n", d, count / seconds);
+    if (d < static_cast<int>(START_PERFT.size()) && count != START_PERFT[d]) {
+      ok = false;
+    }
+  }
+
+  vector<State> states = read_starting_positions("starting_positions.txt");
+  if (states.empty() || samples <= 0) {
+    return ok;
+  }
+  int sample_depth = min(depth, 3);
+  int64_t total = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < samples; ++i) {
+    size_t index = i * states.size() / samples;
+    int64_t count = perft(states[index], sample_depth);
+    printf("perft.sample.%zu.%d %lld\n", index, sample_depth,
+           static_cast<long long>(count));
+    total += count;
+  }
+  printf("perft.sample.states_per_second %.0f\n", total / seconds_since(start));
+  return ok;
+}
+
+// Plays uniformly random games from the start position and the starting
+// positions, checking every state along the way: it unpacks from its
+// pack_state unchanged, all 8 transforms of it have its canonical_key, and
+// each of its plays keeps the hash in step when made with make_play and
+// leaves the state exactly as it was when taken back with unmake_play.
+bool check_random_walks(int games, unsigned int seed) {
+  vector<State> starts = read_starting_positions("starting_positions.txt");
+  starts.push_back(get_start_state());
+  mt19937 rng(seed);
+  int64_t states = 0;
+  int64_t pack_failures = 0;
+  int64_t symmetry_failures = 0;
+  int64_t undo_failures = 0;
+  for (int game = 0; game < games; ++game) {
+    State state = starts[game % starts.size()];
+    while (get_winner(state) < 0) {
+      ++states;
+      State unpacked;
+      if (!unpack_state(pack_state(state), &unpacked) || !(unpacked == state)) {
+        ++pack_failures;
+      }
+      PackedState key = canonical_key(state);
+      for (int t = 0; t < SYMMETRY_COUNT; ++t) {
+        if (!(canonical_key(transform_state(state, t)) == key)) {
+          ++symmetry_failures;
+        }
+      }
+      Plays plays = get_legal_plays(state);
+      for (const Play &play : plays) {
+        State before(state);
+        Undo undo = make_play(&state, play);
+        State synced(state);
+        synced.sync();
+        bool hash_ok = synced.hash == state.hash;
+        unmake_play(&state, play, undo);
+        if (!hash_ok || !(state == before)) {
+          ++undo_failures;
+        }
+      }
+      uniform_int_distribution<int> pick(0, plays.size() - 1);
+      make_play(&state, plays[pick(rng)]);
+    }
+  }
+  printf("walk.states %lld\n", static_cast<long long>(states));
+  printf("walk.pack_failures %lld\n", static_cast<long long>(pack_failures));
+  printf("walk.symmetry_failures %lld\n",
+         static_cast<long long>(symmetry_failures));
+  printf("walk.undo_failures %lld\n", static_cast<long long>(undo_failures));
+  return !pack_failures && !symmetry_failures && !undo_failures;
+}
+
+// Checks that unpack_state rejects keys that no valid board packs to, each
+// made by breaking one field of the start position's key, and accepts the
+// key itself.
+bool check_bad_keys() {
+  const State start = get_start_state();
+  const PackedState start_key = pack_state(start);
+  const int first_pawn = cell_index(start.position[0][0]);
+  vector<PackedState> bad;
+  PackedState key = start_key;
+  key.lo |= uint64_t(MAX_HEIGHT + 1) << (1 * PACKED_HEIGHT_BITS);
+  bad.push_back(key);
+  key = start_key;
+  key.hi |= uint64_t(7); // The height of cell PACKED_LO_CELLS.
+  bad.push_back(key);
+  key = start_key;
+  key.hi |= uint64_t(CELL_COUNT) << PACKED_PAWN_SHIFT;
+  bad.push_back(key);
+  key = start_key;
+  key.lo |= uint64_t(1) << 63;
+  bad.push_back(key);
+  key = start_key;
+  key.hi |= uint64_t(1) << (PACKED_PLAYER_SHIFT + 1);
+  bad.push_back(key);
+  State state = start;
+  state.position[0][1] = state.position[1][0];
+  bad.push_back(pack_state(state));
+  state = start;
+  for (int h = 0; h < MAX_HEIGHT; ++h) {
+    state.levels[h] |= cell_bit(first_pawn);
+  }
+  bad.push_back(pack_state(state));
+  int accepted = 0;
+  for (const PackedState &packed : bad) {
+    accepted += unpack_state(packed, &state);
+  }
+  bool start_ok = unpack_state(start_key, &state) && state == start;
+  printf("keys.bad %zu\n", bad.size());
+  printf("keys.bad_accepted %d\n", accepted);
+  printf("keys.start_ok %d\n", start_ok);
+  return !accepted && start_ok;
+}
+
+// Plays uniformly random games from the start position.
+void bench_random_playouts(int games, unsigned int seed) {
+  mt19937 rng(seed);
+  int64_t plies = 0;
+  int wins[2] = {0, 0};
+  auto start = chrono::steady_clock::now();
+  for (int game = 0; game < games; ++game) {
+    State state = get_start_state();
+    int winner;
+    while ((winner = get_winner(state)) < 0) {
+      Plays plays = get_legal_plays(state);
+      uniform_int_distribution<int> pick(0, plays.size() - 1);
+      state = get_next_state(state, plays[pick(rng)]);
+      ++plies;
+    }
+    ++wins[winner];
+  }
+  double seconds = seconds_since(start);
+  printf("random.games %d\n", games);
+  printf("random.player0_wins %d\n", wins[0]);
+  printf("random.plies %lld\n", static_cast<long long>(plies));
+  printf("random.games_per_second %.0f\n", games / seconds);
+}
+
+// Plays SimplePlayer against itself with play_game.
+void bench_simple_games(int games, unsigned int seed) {
+  SimplePlayer player0(seed);
+  SimplePlayer player1(seed + 1);
+  int wins[2] = {0, 0};
+  auto start = chrono::steady_clock::now();
+  for (int game = 0; game < games; ++game) {
+    State state = get_start_state();
+    ++wins[play_game(&state, &player0, &player1)];
+  }
+  double seconds = seconds_since(start);
+  printf("simple.games %d\n", games);
+  printf("simple.player0_wins %d\n", wins[0]);
+  printf("simple.games_per_second %.0f\n", games / seconds);
+}
+
+// Plays the same games as bench_simple_games, PLAYOUT_LANES at a time with a
+// PlayoutBatch.
+void bench_batch_playouts(int games, uint64_t seed) {
+  PlayoutBatch batch(seed);
+  int wins[2] = {0, 0};
+  auto start = chrono::steady_clock::now();
+  batch.run(get_start_state(), games, wins);
+  double seconds = seconds_since(start);
+  printf("batch.games %d\n", games);
+  printf("batch.player0_wins %d\n", wins[0]);
+  printf("batch.games_per_second %.0f\n", games / seconds);
+}
+
+// Measures a rollout policy's playouts from the start position, and its
+// strength as a player against UniformPolicy, taking each side in turn.
+template <typename RolloutPolicy>
+void bench_policy(const char *name, int games, uint64_t seed) {
+  SerialPlayouts<RolloutPolicy> playouts(seed);
+  int wins[2] = {0, 0};
+  auto start = chrono::steady_clock::now();
+  playouts.run(get_start_state(), games, wins);
+  double seconds = seconds_since(start);
+  printf("policy.%s.games_per_second %.0f\n", name, games / seconds);
+
+  RolloutPolicy policy(seed);
+  UniformPolicy uniform(seed + 1);
+  int policy_wins = 0;
+  for (int game = 0; game < games; ++game) {
+    State state = get_start_state();
+    policy_wins += game % 2 ? play_game(&state, &uniform, &policy) == 1
+                            : play_game(&state, &policy, &uniform) == 0;
+  }
+  printf("policy.%s.win_percent_vs_uniform %.1f\n", name,
+         100.0 * policy_wins / games);
+}
+
+// Plays MonteCarlo with RolloutPolicy against MonteCarlo with
+// FirstPlayPolicy, alternating sides, after timing its simulations from the
+// start position.
+template <typename RolloutPolicy>
+void bench_policy_search(const char *name, int games,
+                         chrono::milliseconds time_limit) {
+  ostringstream discard;
+  streambuf *out = cout.rdbuf(discard.rdbuf());
+  MonteCarlo<true, RolloutPolicy> timed(time_limit);
+  auto start = chrono::steady_clock::now();
+  timed.get_next_play(get_start_state());
+  double seconds = seconds_since(start);
+  int policy_wins = 0;
+  for (int game = 0; game < games; ++game) {
+    MonteCarlo<true, RolloutPolicy> player(time_limit);
+    MonteCarlo<true, FirstPlayPolicy> first(time_limit);
+    State state = get_start_state();
+    policy_wins += game % 2 ? play_game(&state, &first, &player) == 1
+                            : play_game(&state, &player, &first) == 0;
+  }
+  cout.rdbuf(out);
+  printf("mcts.%s.simulations_per_second %.0f\n", name,
+         timed.last_search().games / seconds);
+  if (games > 0) {
+    printf("mcts.%s.win_percent_vs_first %.1f\n", name,
+           100.0 * policy_wins / games);
+  }
+}
+
+// Searches the start position with a single-threaded MonteCarlo.
+void bench_monte_carlo(chrono::milliseconds time_limit) {
+  MonteCarlo<true> player(time_limit);
+  // MonteCarlo reports on cout as it goes, which isn't part of the output.
+  ostringstream discard;
+  streambuf *out = cout.rdbuf(discard.rdbuf());
+  auto start = chrono::steady_clock::now();
+  player.get_next_play(get_start_state());
+  double seconds = seconds_since(start);
+  cout.rdbuf(out);
+  const SearchStats &stats = player.last_search();
+  printf("mcts.simulations %lld\n", static_cast<long long>(stats.games));
+  printf("mcts.max_depth %d\n", stats.max_depth);
+  printf("mcts.simulations_per_second %.0f\n", stats.games / seconds);
+}
+
+int main(int argc, char *argv[]) {
+  // bench [perft_depth [mcts_ms [search_games]]]
+  int depth = argc > 1 ? stoi(argv[1]) : 4;
+  int ms = argc > 2 ? stoi(argv[2]) : 2000;
+  // Games per policy of MonteCarlo against MonteCarlo, at a tenth of mcts_ms
+  // per move. They take minutes, so there are none by default.
+  int search_games = argc > 3 ? stoi(argv[3]) : 0;
+  bool ok = bench_perft(depth, 8);
+  printf("perft.ok %d\n", ok);
+  bool walk_ok = check_random_walks(2000, 1);
+  printf("walk.ok %d\n", walk_ok);
+  ok = ok && walk_ok;
+  bool keys_ok = check_bad_keys();
+  printf("keys.ok %d\n", keys_ok);
+  ok = ok && keys_ok;
+  bench_random_playouts(20000, 1);
+  bench_simple_games(2000, 1);
+  bench_batch_playouts(20000, 1);
+  bench_monte_carlo(chrono::milliseconds(ms));
+  bench_policy<FirstPlayPolicy>("first", 2000, 1);
+  bench_policy<UniformPolicy>("uniform", 2000, 1);
+  bench_policy<BlunderAvoidingPolicy>("blunder_avoiding", 2000, 1);
+  bench_policy<ClimbBiasedPolicy>("climb_biased", 2000, 1);
+  chrono::milliseconds search_ms(ms / 10);
+  bench_policy_search<FirstPlayPolicy>("first", 0, search_ms);
+  bench_policy_search<UniformPolicy>("uniform", search_games, search_ms);
+  bench_policy_search<BlunderAvoidingPolicy>("blunder_avoiding", search_games,
+                                             search_ms);
+  bench_policy_search<ClimbBiasedPolicy>("climb_biased", search_games,
+                                         search_ms);
+  return ok ? 0 : 1;
+}
@@ -1,2 +1,22 @@
 #!/bin/bash
-g++ -std=c++11 -O3 -o santorini -Wall -Wextra -Werror santorini.cc
+# Builds the santorini engine, the bench benchmarks and libsantorini.a, the
+# library behind engine.h.
+#
+# "./build.sh debug" builds them with assertions on and a counting operator
+# new, which checks that MonteCarlo's simulations never allocate.
+# "./build.sh telemetry" adds the phase timers and depth counters to the
+# players' JSON telemetry. "./build.sh sanitize" builds them unoptimized
+# with AddressSanitizer and UndefinedBehaviorSanitizer, which also catches
+# constants that only link once the optimizer has folded them away.
+FLAGS="-O3 -march=native"
+if [ "$1" == "debug" ]; then
+  FLAGS="-O1 -g -march=native -DSANTORINI_COUNT_ALLOCATIONS"
+elif [ "$1" == "telemetry" ]; then
+  FLAGS="-O3 -march=native -DSANTORINI_TELEMETRY"
+elif [ "$1" == "sanitize" ]; then
+  FLAGS="-O0 -g -march=native -fsanitize=address,undefined"
+fi
+g++ -std=c++11 $FLAGS -pthread -o santorini -Wall -Wextra -Werror santorini.cc &&
+g++ -std=c++11 $FLAGS -pthread -o bench -Wall -Wextra -Werror bench.cc &&
+g++ -std=c++11 $FLAGS -pthread -c -o engine.o -Wall -Wextra -Werror engine.cc &&
+ar rcs libsantorini.a engine.o
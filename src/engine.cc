@@ -0,0 +1,228 @@
+// The library behind engine.h, built on santorini.h. The types here are
+// engine.h's, in namespace santorini, and the ones from santorini.h are in
+// santorini::detail.
+
+// The library leaves operator new to the program that links it.
+#undef SANTORINI_COUNT_ALLOCATIONS
+#include "santorini.h"
+
+#include "engine.h"
+
+namespace santorini {
+
+namespace {
+
+detail::Position to_board(const Position &p) {
+  return detail::Position(p.x, p.y);
+}
+
+Position from_board(const detail::Position &p) {
+  Position position = {p.x, p.y};
+  return position;
+}
+
+detail::Play to_board(const Play &play) {
+  detail::Play board_play;
+  board_play.pawn = play.pawn;
+  board_play.end = to_board(play.end);
+  board_play.build = to_board(play.build);
+  return board_play;
+}
+
+Play from_board(const detail::Play &board_play) {
+  Play play;
+  play.pawn = board_play.pawn;
+  play.end = from_board(board_play.end);
+  play.build = from_board(board_play.build);
+  return play;
+}
+
+detail::State to_board(const State &state) {
+  detail::State board = detail::State();
+  board.player = state.player;
+  for (int player = 0; player < 2; ++player) {
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      board.position[player][pawn] = to_board(state.position[player][pawn]);
+    }
+  }
+  for (int x = 0; x < BOARD_WIDTH; ++x) {
+    for (int y = 0; y < BOARD_WIDTH; ++y) {
+      for (int level = 0; level < state.height[y][x]; ++level) {
+        board.levels[level] |= detail::cell_bit(detail::Position(x, y));
+      }
+    }
+  }
+  board.sync();
+  return board;
+}
+
+State from_board(const detail::State &board) {
+  State state;
+  state.player = board.player;
+  for (int player = 0; player < 2; ++player) {
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      state.position[player][pawn] = from_board(board.position[player][pawn]);
+    }
+  }
+  for (int x = 0; x < BOARD_WIDTH; ++x) {
+    for (int y = 0; y < BOARD_WIDTH; ++y) {
+      state.height[y][x] = board.get_height(detail::Position(x, y));
+    }
+  }
+  return state;
+}
+
+bool on_board(const Position &p) {
+  return p.x >= 0 && p.x < BOARD_WIDTH && p.y >= 0 && p.y < BOARD_WIDTH;
+}
+
+} // namespace
+
+State start_state() { return from_board(detail::get_start_state()); }
+
+bool is_valid(const State &state) {
+  if (state.player != 0 && state.player != 1) {
+    return false;
+  }
+  for (int x = 0; x < BOARD_WIDTH; ++x) {
+    for (int y = 0; y < BOARD_WIDTH; ++y) {
+      if (state.height[y][x] < 0 || state.height[y][x] > MAX_HEIGHT) {
+        return false;
+      }
+    }
+  }
+  detail::Bitboard occupied = 0;
+  for (int player = 0; player < 2; ++player) {
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      const Position &p = state.position[player][pawn];
+      if (!on_board(p) || state.height[p.y][p.x] == MAX_HEIGHT ||
+          (occupied & detail::cell_bit(to_board(p)))) {
+        return false;
+      }
+      occupied |= detail::cell_bit(to_board(p));
+    }
+  }
+  return true;
+}
+
+int winner(const State &state) { return detail::get_winner(to_board(state)); }
+
+std::vector<Play> legal_plays(const State &state) {
+  std::vector<Play> plays;
+  for (const detail::Play &play : detail::get_legal_plays(to_board(state))) {
+    plays.push_back(from_board(play));
+  }
+  return plays;
+}
+
+State next_state(const State &state, const Play &play) {
+  return from_board(detail::get_next_state(to_board(state), to_board(play)));
+}
+
+std::string state_key(const State &state) {
+  return detail::packed_to_string(detail::pack_state(to_board(state)));
+}
+
+// unpack_state checks every field of the key before it builds the board,
+// so keys from anywhere are safe here.
+bool state_from_key(const std::string &key, State *state) {
+  detail::PackedState packed;
+  detail::State board;
+  if (!detail::packed_from_string(key, &packed) ||
+      !detail::unpack_state(packed, &board)) {
+    return false;
+  }
+  *state = from_board(board);
+  return true;
+}
+
+std::string play_to_text(const Play &play) {
+  return detail::play_to_text(to_board(play));
+}
+
+bool play_from_text(const std::string &text, const State &state, Play *play) {
+  detail::Play board_play;
+  if (!detail::play_from_text(text, to_board(state), &board_play)) {
+    return false;
+  }
+  *play = from_board(board_play);
+  return true;
+}
+
+// A single-threaded MonteCarlo for each of the pool's threads.
+struct Engine::Searchers {
+  Searchers(int threads, std::size_t memory_bytes, std::uint64_t seed)
+      : pool(threads) {
+    for (int worker = 0; worker < pool.size(); ++worker) {
+      players.emplace_back(new detail::MonteCarlo<true>(
+          std::chrono::milliseconds(1000), 1, memory_bytes / pool.size()));
+      players.back()->set_log(nullptr);
+      // Far enough apart that no two players ever share a rollout seed.
+      players.back()->set_rollout_seed(seed + (std::uint64_t(worker) << 40));
+    }
+  }
+
+  // Searches state with player, which has its budget set already.
+  static Analysis analyze(detail::MonteCarlo<true> *player,
+                          const State &state) {
+    Analysis analysis = Analysis();
+    analysis.play.pawn = -1;
+    detail::State board = to_board(state);
+    int winner = detail::get_winner(board);
+    if (winner >= 0) {
+      analysis.win_percent = winner == state.player;
+      analysis.proven = true;
+      return analysis;
+    }
+    analysis.play = from_board(player->get_next_play(board));
+    const detail::SearchStats &stats = player->last_search();
+    analysis.win_percent = stats.win_percent;
+    analysis.proven = stats.proven;
+    analysis.simulations = stats.games;
+    analysis.seconds = stats.seconds;
+    return analysis;
+  }
+
+  detail::ThreadPool pool;
+  std::vector<std::unique_ptr<detail::MonteCarlo<true>>> players;
+  std::mutex turn; // Held for each call to the Engine.
+};
+
+Engine::Engine(int threads, std::size_t memory_bytes, std::uint64_t seed)
+    : searchers_(new Searchers(std::max(threads, 1), memory_bytes, seed)) {}
+
+Engine::~Engine() {}
+
+int Engine::threads() const { return searchers_->pool.size(); }
+
+Analysis Engine::analyze(const State &state, const Budget &budget) {
+  std::lock_guard<std::mutex> lock(searchers_->turn);
+  detail::MonteCarlo<true> *player = searchers_->players[0].get();
+  player->set_time_manager(detail::TimeManager::hard_limit(budget.time));
+  player->set_simulation_limit(budget.simulations);
+  return Searchers::analyze(player, state);
+}
+
+std::vector<Analysis> Engine::analyze_batch(const State *states,
+                                            std::size_t count,
+                                            const Budget &budget) {
+  std::lock_guard<std::mutex> lock(searchers_->turn);
+  std::vector<Analysis> analyses(count);
+  std::vector<int> tasks(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    tasks[i] = i;
+  }
+  detail::WorkStealingQueue queue(tasks, searchers_->pool.size());
+  searchers_->pool.run([&](int worker) {
+    detail::MonteCarlo<true> *player = searchers_->players[worker].get();
+    player->set_time_manager(detail::TimeManager::hard_limit(budget.time));
+    player->set_simulation_limit(budget.simulations);
+    int task;
+    while (queue.pop(worker, &task)) {
+      analyses[task] = Searchers::analyze(player, states[task]);
+    }
+  });
+  return analyses;
+}
+
+} // namespace santorini
@@ -0,0 +1,115 @@
+#ifndef SANTORINI_ENGINE_H
+#define SANTORINI_ENGINE_H
+
+// The santorini library: the rules and MonteCarlo analysis behind a small
+// API, for programs that link libsantorini.a rather than run the santorini
+// binary. It doesn't print, and each Engine has its own threads and trees,
+// so any number of them can run in one process.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace santorini {
+
+constexpr int BOARD_WIDTH = 5;
+constexpr int PAWN_COUNT = 2;
+constexpr int MAX_HEIGHT = 4; // A dome.
+
+struct Position {
+  int x;
+  int y;
+};
+
+struct Play {
+  int pawn; // Of the player to move, or -1 for no play.
+  Position end;
+  Position build;
+};
+
+struct State {
+  int player; // The player to move, 0 or 1.
+  Position position[2][PAWN_COUNT]; // First index is player.
+  int height[BOARD_WIDTH][BOARD_WIDTH]; // By y, then x.
+};
+
+// The usual opening position, with player 0 to move.
+State start_state();
+
+// Whether the cells and heights are on the board, and the pawns stand on
+// different cells without domes. The other calls take only valid states.
+bool is_valid(const State &state);
+
+// The winner, or -1 while the game goes on.
+int winner(const State &state);
+
+std::vector<Play> legal_plays(const State &state);
+
+State next_state(const State &state, const Play &play);
+
+// States as the 32 hex digit keys of the santorini binary's results and
+// engine mode. state_from_key returns false, leaving *state alone, unless
+// key is the key of a valid state.
+std::string state_key(const State &state);
+bool state_from_key(const std::string &key, State *state);
+
+// Plays as the engine mode writes them, such as "0b2c3" for pawn 0 moving
+// to (1, 1) and building on (2, 2). play_from_text returns false unless
+// text is a legal play in state.
+std::string play_to_text(const Play &play);
+bool play_from_text(const std::string &text, const State &state, Play *play);
+
+// How long to search each position. A search ends at whichever limit comes
+// first, or sooner when its choice is settled.
+struct Budget {
+  std::chrono::milliseconds time;
+  std::int64_t simulations; // 0 for no limit.
+};
+
+struct Analysis {
+  Play play; // The best play, with pawn -1 when the game is over.
+  // The chance that play wins, from 0 to 1, or 0.5 when it wasn't
+  // evaluated, as when it is the only legal play.
+  double win_percent;
+  bool proven; // Whether win_percent is exactly 0 or 1.
+  std::int64_t simulations;
+  double seconds;
+};
+
+// Searches positions with a pool of threads. Each thread has its own
+// MonteCarlo, and so its own tree, which it keeps between the positions it
+// is given while they follow on from each other.
+//
+// Calls on one Engine from several threads take turns.
+class Engine {
+public:
+  // Uses threads threads and about memory_bytes for their trees.
+  explicit Engine(int threads = 1,
+                  std::size_t memory_bytes = std::size_t(256) << 20,
+                  std::uint64_t seed = 1);
+  ~Engine();
+  Engine(const Engine &) = delete;
+  Engine &operator=(const Engine &) = delete;
+
+  int threads() const;
+
+  // Searches one position, on one thread.
+  Analysis analyze(const State &state, const Budget &budget);
+
+  // Searches count positions starting at states, each with the whole budget
+  // on one thread, sharing them out between the threads. Returns the
+  // analyses in the same order.
+  std::vector<Analysis> analyze_batch(const State *states, std::size_t count,
+                                      const Budget &budget);
+
+private:
+  struct Searchers;
+  std::unique_ptr<Searchers> searchers_;
+};
+
+} // namespace santorini
+
+#endif // SANTORINI_ENGINE_H
@@ -1,899 +1,625 @@
-#include <algorithm>
-#include <cassert>
-#include <chrono>
-#include <cmath>
-#include <cstdio>
-#include <cstring>
-#include <fstream>
-#include <functional>
-#include <iostream>
-#include <limits>
-#include <random>
-#include <tuple>
-#include <unordered_map>
-#include <unordered_set>
-#include <vector>
+#include "santorini.h"
 
 using namespace std;
+using namespace santorini::detail;
 
-// The board is a 5x5 square of cells.
-constexpr int BOARD_WIDTH = 5;
-
-// Each player has 2 pawns.
-constexpr int PAWN_COUNT = 2;
-
-// Maximum height for each cell.
-constexpr int MAX_HEIGHT = 4;
-
-// Each pawn could have 8 places to move and then 8 places to build;
-constexpr int MAX_LEGAL_MOVES = PAWN_COUNT * 8 * 8;
-
-// A vector with a maximum length of N.
-//
-// It doesn't do checks for you though, so it's up to you not to overfill it.
-template <typename T, int N> class SmallVec {
-public:
-  SmallVec() : length_(0) {}
-
-  void push_back(const T &val) {
-    values_[length_] = val;
-    ++length_;
-  }
-
-  T &operator[](int n) { return values_[n]; }
-  const T &operator[](int n) const { return values_[n]; }
-  T *begin() { return values_; }
-  T *end() { return values_ + length_; }
-  const T *begin() const { return values_; }
-  const T *end() const { return values_ + length_; }
-  int size() const { return length_; }
-
-private:
-  int length_;
-  T values_[N];
-};
-
-struct Position {
-  int x;
-  int y;
-
-  Position() {}
-  Position(int x, int y) : x(x), y(y) {}
-
-  bool operator==(const Position &that) const {
-    return that.x == x && that.y == y;
-  }
-
-  bool operator!=(const Position &that) const { return !(*this == that); }
-};
-
-struct State {
-  int player;
-  Position position[2][PAWN_COUNT];     // First index is player.
-  int height[BOARD_WIDTH][BOARD_WIDTH]; // First index is y, second is x.
-
-  bool operator==(const State &that) const {
-    return 0 == memcmp(this, &that, sizeof(that));
-  }
-
-  int get_height(const Position &p) const { return height[p.y][p.x]; }
+void ref_games(unsigned int seed, const OpeningBook *book = nullptr) {
+  printf("Seed = %u\n", seed);
+  mt19937 rng(seed);
 
-  int get_height(int player, int pawn) const {
-    Position p = position[player][pawn];
-    return height[p.y][p.x];
+  int counts[2] = {0, 0};
+  MonteCarlo<true> player0(chrono::seconds(10));
+  MonteCarlo<true> player1(chrono::seconds(10));
+  player0.set_book(book);
+  player1.set_book(book);
+  for (int trial = 0; trial < 1; ++trial) {
+    State state = get_start_state();
+    print_state(state);
+    printf("\n");
+    int winner = play_game<true>(&state, &player0, &player1);
+    ++counts[winner];
+    printf("Trial %3d won by player %d (%d to %d).\n", trial, winner, counts[0],
+           counts[1]);
   }
+  printf("\nPlayer 0 wins %d times, player 1 wins %d times.\n", counts[0],
+         counts[1]);
+}
 
-  int increment_height(const Position &p) { return ++height[p.y][p.x]; }
-
-  bool is_pawn_at(const Position &p) const {
-    for (int player = 0; player < 2; ++player) {
-      for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
-        if (position[player][pawn] == p) {
-          return true;
-        }
-      }
+// Plays NegamaxPlayer against MonteCarlo with the same time per move,
+// alternating who goes first. With a game_time, each player instead gets a
+// clock of game_time for the whole game.
+void play_negamax_match(int games, chrono::milliseconds time_limit,
+                        chrono::milliseconds game_time) {
+  int negamax_wins = 0;
+  for (int game = 0; game < games; ++game) {
+    NegamaxPlayer negamax(time_limit);
+    MonteCarlo<true> monte_carlo(time_limit);
+    if (game_time.count() > 0) {
+      negamax.set_time_manager(TimeManager::game_clock(game_time));
+      monte_carlo.set_time_manager(TimeManager::game_clock(game_time));
     }
-    return false;
-  }
-
-  bool is_blocked(const Position &p) const {
-    return height[p.y][p.x] == MAX_HEIGHT || is_pawn_at(p);
+    State state = get_start_state();
+    bool negamax_first = game % 2 == 0;
+    int winner = negamax_first ? play_game(&state, &negamax, &monte_carlo)
+                               : play_game(&state, &monte_carlo, &negamax);
+    bool negamax_won = winner == (negamax_first ? 0 : 1);
+    negamax_wins += negamax_won;
+    printf("Game %d won by %s. Negamax %d, MonteCarlo %d.\n", game,
+           negamax_won ? "negamax" : "MonteCarlo", negamax_wins,
+           game + 1 - negamax_wins);
   }
+}
 
-  bool heights_can_happen_given(const State &s) const {
-    for (int y = 0; y < BOARD_WIDTH; ++y) {
-      for (int x = 0; x < BOARD_WIDTH; ++x) {
-        if (s.height[y][x] < height[y][x]) {
-          return false;
-        }
-      }
+// Measures how MonteCarlo's simulation rate scales with the thread count,
+// searching the start position for the same time with 1, 2, 4, ... threads.
+void report_thread_scaling(int max_threads, chrono::milliseconds time_limit) {
+  printf("threads games_per_second speedup\n");
+  double base_rate = 0;
+  for (int threads = 1;; threads = min(2 * threads, max_threads)) {
+    MonteCarlo<true> player(time_limit, threads);
+    player.get_next_play(get_start_state());
+    const SearchStats &stats = player.last_search();
+    double rate = stats.games / stats.seconds;
+    if (threads == 1) {
+      base_rate = rate;
+    }
+    printf("%d %.0f %.2f\n", threads, rate, rate / base_rate);
+    if (threads == max_threads) {
+      break;
     }
-    return true;
-  }
-};
-
-struct Play {
-  int pawn;
-  Position end;
-  Position build;
-
-  bool operator==(const Play &that) const {
-    return pawn == that.pawn && end == that.end && build == that.build;
   }
-};
-
-using Plays = SmallVec<Play, MAX_LEGAL_MOVES>;
+}
 
-struct Counts {
-  double wins;
-  double plays;
+// The number of fields on each line of a sweep's results file.
+constexpr int RESULT_FIELDS = 18;
 
-  Counts() : wins(0), plays(0) {}
-  Counts(double wins, double plays) : wins(wins), plays(plays) {}
+// One line of a sweep's results file.
+struct PositionResult {
+  int index;
+  PackedState key;
+  State state;
+  Play play;
+  double win_percent;
+  long long games;
+  int max_depth;
 };
 
-using Neighbors = SmallVec<Position, 8>;
-
-namespace std {
-// We need this so we can use State as the key in an unordered_map.
-template <> struct hash<State> {
-  size_t operator()(const State &state) const {
-    hash<int> int_hash;
-    size_t result = int_hash(state.player);
-    for (int player = 0; player < 2; ++player) {
-      for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
-        result = (result << 1) ^ int_hash(state.position[player][pawn].x);
-        result = (result << 1) ^ int_hash(state.position[player][pawn].y);
-      }
-    }
-    for (int x = 0; x < BOARD_WIDTH; ++x) {
-      for (int y = 0; y < BOARD_WIDTH; ++y) {
-        result = (result << 1) ^ int_hash(state.height[y][x]);
-      }
-    }
-    return result;
+// Reads a line written by evaluate_starting_positions. Returns false if it
+// isn't a complete one.
+bool parse_result(const string &line, PositionResult *result) {
+  istringstream fields(line);
+  string field;
+  int field_count = 0;
+  while (fields >> field) {
+    if (field_count == 1 && !packed_from_string(field, &result->key)) {
+      return false;
+    }
+    ++field_count;
   }
-};
-} // namespace std
-
-// Finds the neighboring positions of a given position.
-Neighbors get_neighbors(const Position &p) {
-  Neighbors results;
-  for (int dy = -1; dy < 2; ++dy) {
-    for (int dx = -1; dx < 2; ++dx) {
-      int x = p.x + dx;
-      int y = p.y + dy;
-      if ((dx || dy) && x >= 0 && y >= 0 && x < BOARD_WIDTH &&
-          y < BOARD_WIDTH) {
-        results.push_back(Position(x, y));
-      }
-    }
+  if (field_count != RESULT_FIELDS) {
+    return false;
   }
-  return results;
+  istringstream values(line);
+  Position p[2][PAWN_COUNT];
+  values
+    >> result->index >> field
+    >> p[0][0].x >> p[0][0].y
+    >> p[0][1].x >> p[0][1].y
+    >> p[1][0].x >> p[1][0].y
+    >> p[1][1].x >> p[1][1].y
+    >> result->play.pawn
+    >> result->play.end.x >> result->play.end.y
+    >> result->play.build.x >> result->play.build.y
+    >> result->win_percent >> result->games >> result->max_depth;
+  if (!values || result->index < 0) {
+    return false;
+  }
+  result->state = get_start_state();
+  memcpy(result->state.position, p, sizeof(p));
+  result->state.sync();
+  return true;
 }
 
-void print_state(const State &state) {
-  cout << "Next player = " << state.player << "\n";
-  char screen[11][26];
-  for (int y = 0; y < 11; ++y) {
-    for (int x = 0; x < 26; ++x) {
-      screen[y][x] = ' ';
-    }
-  }
-  for (int y = 0; y < 5; ++y) {
-    for (int x = 0; x < 5; ++x) {
-      screen[2 * y][5 * x] = '+';
-      screen[2 * y][5 * x + 1] = '-';
-      screen[2 * y][5 * x + 2] = '-';
-      screen[2 * y][5 * x + 3] = '-';
-      screen[2 * y][5 * x + 4] = '-';
-      screen[2 * y + 1][5 * x] = '|';
-      screen[2 * y + 1][5 * x + 1] = '0' + state.height[y][x];
-    }
-  }
-  for (int player = 0; player < 2; ++player) {
-    for (int pawn = 0; pawn < 2; ++pawn) {
-      Position p = state.position[player][pawn];
-      screen[2 * p.y + 1][5 * p.x + 2] = ':';
-      screen[2 * p.y + 1][5 * p.x + 3] = player ? 'b' : 'a';
-      screen[2 * p.y + 1][5 * p.x + 4] = '0' + pawn;
+// Returns the indices of the positions that already have a complete line in
+// the results file, so that a killed sweep can pick up where it stopped.
+vector<bool> read_finished_positions(const string &path, size_t count) {
+  vector<bool> finished(count);
+  fstream fs(path, fstream::in);
+  string line;
+  while (getline(fs, line)) {
+    if (fs.eof()) {
+      // The last line has no newline, so it was cut off mid-write.
+      break;
     }
-  }
-  for (int y = 0; y < 11; ++y) {
-    for (int x = 0; x < 26; ++x) {
-      cout << screen[y][x];
+    PositionResult result;
+    if (parse_result(line, &result) &&
+        static_cast<size_t>(result.index) < count) {
+      finished[result.index] = true;
     }
-    cout << "\n";
   }
+  return finished;
 }
 
-State get_start_state() {
-  State state;
-  memset(&state, 0, sizeof(state));
-  state.position[0][0] = Position(0, 0);
-  state.position[0][1] = Position(4, 4);
-  state.position[1][0] = Position(0, 4);
-  state.position[1][1] = Position(4, 0);
-  return state;
-}
-
-State get_next_state(const State &state, const Play &play) {
-  State result(state);
-  result.player = 1 - state.player;
-  result.position[state.player][play.pawn] = play.end;
-  result.increment_height(play.build);
-  return result;
-}
-
-bool has_legal_play(const State &state) {
-  for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
-    Position start = state.position[state.player][pawn];
-    for (Position end : get_neighbors(start)) {
-      int height_change = state.get_height(end) - state.get_height(start);
-      if (state.is_blocked(end) || height_change > 1) {
-        continue;
-      }
-      return true;
+// Searches every position in starting_positions.txt and appends one line per
+// position to the results file, flushed as soon as it is known:
+//
+//   index key x0 y0 x1 y1 x2 y2 x3 y3 pawn end_x end_y build_x build_y
+//   win_percent games max_depth
+//
+// with the canonical_key of the position in hex, the pawn positions as in
+// the input, the best play for player 0 and the search's estimate of
+// player 0's chances with it. Positions that already have a line are
+// skipped, so rerunning after a crash resumes the sweep. Lines are in order
+// of completion, not of index.
+//
+// The searches' telemetry records go to the results path plus
+// ".telemetry.jsonl", one JSON line per position with the same key.
+void evaluate_starting_positions(const string &results_path,
+                                 chrono::milliseconds time_limit,
+                                 int thread_count, size_t memory_bytes) {
+  vector<State> states = read_starting_positions("starting_positions.txt");
+  vector<bool> finished = read_finished_positions(results_path, states.size());
+  vector<int> tasks;
+  for (size_t i = 0; i < states.size(); ++i) {
+    if (!finished[i]) {
+      tasks.push_back(i);
     }
   }
-  return false;
-}
+  printf("%zu of %zu positions left to evaluate.\n", tasks.size(),
+         states.size());
 
-Plays get_legal_plays(const State &state) {
-  Plays plays;
-  for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
-    Position start = state.position[state.player][pawn];
-    for (Position end : get_neighbors(start)) {
-      int height_change = state.get_height(end) - state.get_height(start);
-      if (state.is_blocked(end) || height_change > 1) {
-        continue;
-      }
-      Play play;
-      play.pawn = pawn;
-      play.end = end;
-      play.build = start;
-      plays.push_back(play);
-      for (Position build : get_neighbors(end)) {
-        if (state.is_blocked(build)) {
-          continue;
-        }
-        play.build = build;
-        plays.push_back(play);
-      }
+  fstream out(results_path, fstream::in | fstream::out | fstream::app);
+  out.seekg(0, ios::end);
+  if (out.tellg() > 0) {
+    out.seekg(-1, ios::end);
+    if (out.get() != '\n') {
+      // Finish off a line cut short by a crash, so that it gets ignored.
+      out << '\n';
     }
   }
-  return plays;
+  fstream telemetry_out(results_path + ".telemetry.jsonl",
+                        fstream::out | fstream::app);
+  mutex out_mutex;
+
+  ThreadPool pool(thread_count);
+  WorkStealingQueue queue(tasks, pool.size());
+  atomic<int> done(0);
+  pool.run([&](int worker) {
+    // Every worker reuses one player, but each position gets a fresh tree.
+    MonteCarlo<true> player(time_limit, 1, memory_bytes / pool.size());
+    // Its progress reports would interleave with the lines written under
+    // out_mutex.
+    player.set_log(nullptr);
+    ostringstream telemetry;
+    player.set_telemetry(&telemetry);
+    int index;
+    while (queue.pop(worker, &index)) {
+      const State &state = states[index];
+      Play play = player.get_next_play(state);
+      const SearchStats &stats = player.last_search();
+      char line[256];
+      snprintf(line, sizeof(line),
+               "%d %s %d %d %d %d %d %d %d %d %d %d %d %d %d %.6f %lld %d\n",
+               index, packed_to_string(canonical_key(state)).c_str(),
+               state.position[0][0].x, state.position[0][0].y,
+               state.position[0][1].x, state.position[0][1].y,
+               state.position[1][0].x, state.position[1][0].y,
+               state.position[1][1].x, state.position[1][1].y, play.pawn,
+               play.end.x, play.end.y, play.build.x, play.build.y,
+               stats.win_percent, static_cast<long long>(stats.games),
+               stats.max_depth);
+      {
+        lock_guard<mutex> lock(out_mutex);
+        out << line << flush;
+        telemetry_out << telemetry.str() << flush;
+      }
+      telemetry.str("");
+      printf("Finished position %d (%d of %zu).\n", index, ++done,
+             tasks.size());
+    }
+  });
 }
 
-int get_winner(const State &state) {
-  for (int player = 0; player < 2; ++player) {
-    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
-      Position p = state.position[player][pawn];
-      if (state.get_height(p) == MAX_HEIGHT - 1) {
-        return player;
+// Builds an opening book from the lines of one or more sweep results files.
+// Returns false if the book can't be written.
+bool build_book(const string &book_path, const vector<string> &results_paths) {
+  vector<BookRecord> records;
+  for (const string &path : results_paths) {
+    fstream fs(path, fstream::in);
+    string line;
+    while (getline(fs, line)) {
+      PositionResult result;
+      if (!parse_result(line, &result) || result.games <= 0) {
+        continue;
       }
+      int t;
+      canonicalize(result.state, &t);
+      const uint8_t *cell = SYMMETRIES.cell[t];
+      BookRecord record = BookRecord();
+      record.key = result.key;
+      record.visits = min<long long>(result.games,
+                                     numeric_limits<uint32_t>::max());
+      record.wins = llround(result.win_percent * record.visits);
+      record.start = cell[cell_index(
+          result.state.position[result.state.player][result.play.pawn])];
+      record.end = cell[cell_index(result.play.end)];
+      record.build = cell[cell_index(result.play.build)];
+      records.push_back(record);
     }
   }
-  if (!has_legal_play(state)) {
-    return 1 - state.player;
-  }
-  return -1;
+  printf("Read %zu results.\n", records.size());
+  return OpeningBook::write(book_path, records);
 }
 
-// Simple AI that looks ahead to the opponent's next move.
-class SimplePlayer {
-public:
-  SimplePlayer(unsigned int seed) : rng_(seed) {}
-
-  int select_move(const State &state, const Plays &plays) {
-    int obvious = get_obvious_move(state, plays);
-    if (obvious >= 0) {
-      return obvious;
-    }
-
-    auto blunders = get_blunders(state, plays);
-    if (blunders.size() == plays.size()) {
-      // All the moves are losers, so just pick the first one,
-      // you loser.
-      return 0;
-    }
-
-    // Choose at random from among the non-losing moves.
-    std::uniform_int_distribution<int> uni(0,
-                                           plays.size() - blunders.size() - 1);
-    int rand = uni(rng_);
-    int skip = rand;
-    int base = 0;
-    for (int blunder : blunders) {
-      if (base + skip < blunder) {
-        return base + skip;
-      }
-      skip -= blunder - base;
-      base = blunder + 1;
-    }
-
-    if (base + skip >= plays.size()) {
-      // It shouldn't be possible to get here.
-      std::fprintf(stderr,
-                   "Couldn't find %d winners from "
-                   "%d moves minus %d losers\n",
-                   rand, plays.size(), blunders.size());
-      std::exit(EXIT_FAILURE);
-    }
-
-    return base + skip;
-  }
-
-protected:
-  int get_obvious_move(const State &state, const Plays &plays) {
-    // First see if any of the moves wins the game.
-    // If so, select that move.
-    for (int i = 0; i < plays.size(); ++i) {
-      Play play = plays[i];
-      if (state.get_height(play.end) == MAX_HEIGHT - 1) {
-        return i;
-      }
-    }
-
-    // Check if a single move stops the other player from winning.
-    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
-      Position them = state.position[1 - state.player][pawn];
-      if (state.get_height(them) == MAX_HEIGHT - 2) {
-        // This pawn is at the right height to win on the next move.
-        for (Position end : get_neighbors(them)) {
-          if (state.get_height(end) == MAX_HEIGHT - 1) {
-            // This move will win the game for the opponent,
-            // so try to build here. We know we can't move here
-            // because we checked that above.
-            int stopper_index = -1;
-            bool stopper_seen = false;
-            for (int i = 0; i < plays.size(); ++i) {
-              if (plays[i].build == end) {
-                if (stopper_seen) {
-                  // More than one way to stop them, so
-                  // it's not obvious what to do.
-                  return -1;
-                }
-                stopper_seen = true;
-                stopper_index = i;
-              }
-            }
-            if (stopper_seen) {
-              // This stops this particular winning move for
-              // the opponent, but the opponent may have other
-              // winning moves. In any case, we can only stop
-              // one so do not bother checking for others.
-              return stopper_index;
-            } else {
-              // The other user is going to win and we have no
-              // way to stop it, so just give up.
-              return 0;
-            }
-          }
-        }
-      }
-    }
-    // No obvious move found, return -1.
-    return -1;
+// The Elo difference at which the stronger player is expected to score
+// score, the share of the games it wins.
+double elo_from_score(double score) { return -400 * log10(1 / score - 1); }
+
+double score_from_elo(double elo) { return 1 / (1 + pow(10, -elo / 400)); }
+
+// The running result of a match, from the first player's side.
+struct MatchResult {
+  int games;
+  int wins;
+
+  MatchResult() : games(0), wins(0) {}
+
+  // The share of the games won, nudged away from 0 and 1 so that a clean
+  // sweep still has a finite Elo and variance.
+  double score() const { return (wins + 0.5) / (games + 1); }
+
+  // The Elo difference, setting *margin to the half-width of its 95%
+  // confidence interval. Games are counted as independent, though the two
+  // games of an opening aren't quite.
+  double elo(double *margin) const {
+    double p = score();
+    double error = 1.96 * sqrt(p * (1 - p) / max(games, 1));
+    *margin = (elo_from_score(min(p + error, 0.999)) -
+               elo_from_score(max(p - error, 0.001))) /
+              2;
+    return elo_from_score(p);
   }
 
-  SmallVec<int, MAX_LEGAL_MOVES> get_blunders(const State &state,
-                                              const Plays &plays) {
-    SmallVec<int, MAX_LEGAL_MOVES> blunders;
-    for (int i = 0; i < plays.size(); ++i) {
-      Position build = plays[i].build;
-      if (state.get_height(build) == MAX_HEIGHT - 2) {
-        // This makes a tower of winning height,
-        // make sure no opponent is nearby.
-        for (int pawn = 0; pawn < 2; ++pawn) {
-          Position them = state.position[1 - state.player][pawn];
-          int dx = them.x - build.x;
-          int dy = them.y - build.y;
-          int d2 = dx * dx + dy * dy; // Squared horizontal distance.
-          int height = state.get_height(them);
-          if (d2 <= 2 && height == MAX_HEIGHT - 2) {
-            // Opponent is close enough, vertically and
-            // horizontally, so do not choose this move.
-            blunders.push_back(i);
-            break;
-          }
-        }
-      }
-    }
-    return blunders;
+  // The log-likelihood ratio of the Elo difference being elo1 rather than
+  // elo0, by the normal approximation that fishtest's SPRT uses.
+  double llr(double elo0, double elo1) const {
+    double p = score();
+    double s0 = score_from_elo(elo0);
+    double s1 = score_from_elo(elo1);
+    return games * (s1 - s0) * (2 * p - s0 - s1) / (2 * p * (1 - p));
   }
-
-  std::mt19937 rng_;
 };
 
-template <bool DO_IMMEDIATE_WIN_CHECK> class MonteCarlo {
-public:
-  MonteCarlo(chrono::milliseconds time_limit) : time_limit_(time_limit) {}
-
-  int select_move(const State &state, const Plays &plays) {
-    Play play = get_next_play(state);
-    for (int i = 0; i < plays.size(); ++i) {
-      if (play == plays[i]) {
-        return i;
-      }
+// Plays player a against player b, as make_player specs, with games on
+// threads at once. Each opening from starting_positions.txt, in a shuffled
+// order, is played twice with the players swapping colors.
+//
+// Stops after max_games, or as soon as a sequential probability ratio test
+// of a being elo1 rather than elo0 stronger than b accepts either, with 5%
+// error rates. Only whole pairs of games count. Returns false if a spec
+// isn't a player.
+bool run_tournament(const string &spec_a, const string &spec_b, int max_games,
+                    int threads, double elo0, double elo1) {
+  for (const string &spec : {spec_a, spec_b}) {
+    if (!make_player(spec, 0)) {
+      fprintf(stderr, "Unknown player %s\n", spec.c_str());
+      return false;
     }
-    cout << "No valid move selected. Picking the first.\n";
-    return -1;
   }
-
-  Play get_next_play(const State &state) {
-    max_depth_ = 0;
-    Plays legal = get_legal_plays(state);
-
-    if (!legal.size()) {
-      Play play;
-      play.pawn = -1; // Negative pawn means error.
-      return play;
-    } else if (legal.size() == 1) {
-      return legal[0];
-    }
-
-    if (DO_IMMEDIATE_WIN_CHECK) {
-      for (Play play : legal) {
-        if (state.get_height(play.end) == MAX_HEIGHT - 1) {
-          return play;
-        }
-      }
-    }
-
-    int games = 0;
-    const auto start_time = chrono::steady_clock::now();
-    while (chrono::steady_clock::now() - start_time < time_limit_) {
-      run_simulation(state);
-      games++;
-    }
-
-    cout << "Game count = " << games << "\n";
-
-    Play best_play;
-    State best_next_state = state;
-    double best_win_percent = -1;
-    for (const Play &play : legal) {
-      State next_state = get_next_state(state, play);
-      auto iter = state_counts_.find(next_state);
-      double win_percent = iter == state_counts_.end()
-                               ? 0.0
-                               : iter->second.wins / iter->second.plays;
-      if (win_percent > best_win_percent) {
-        best_win_percent = win_percent;
-        best_play = play;
-        best_next_state = next_state;
-      }
-    }
-    cout << "max depth = " << max_depth_ << "\n";
-    cout << "win percent = " << best_win_percent << "\n";
-    erase_early_states(best_next_state);
-    return best_play;
+  vector<State> openings = read_starting_positions("starting_positions.txt");
+  if (openings.empty()) {
+    openings.push_back(get_start_state());
+  }
+  shuffle(openings.begin(), openings.end(), mt19937(1));
+  vector<int> pairs;
+  for (int pair = 0; pair < max_games / 2; ++pair) {
+    pairs.push_back(pair);
   }
 
-private:
-  void run_simulation(const State &state) {
-    unordered_set<State> visited_states;
-
-    bool expand = true;
-    int winner = -1;
-    State this_state = state;
-    for (int t = 0;; ++t) {
-      Plays legal = get_legal_plays(this_state);
-
-      if (DO_IMMEDIATE_WIN_CHECK) {
-        // Check for an immediate winning move.
-        for (int pawn = 0; pawn < 2; ++pawn) {
-          Position p = this_state.position[this_state.player][pawn];
-          if (this_state.get_height(p) == MAX_HEIGHT - 2) {
-            // This pawn is just below the winning height.
-            //
-            // If it has a neighbor at winning height, then there
-            // is a winning move for the current player.
-            for (Position n : get_neighbors(p)) {
-              if (this_state.get_height(n) == MAX_HEIGHT - 1) {
-                winner = this_state.player;
-                break;
-              }
-            }
-          }
-        }
-        if (winner >= 0) {
-          // Mark all moves ending on MAX_HEIGHT - 1 as visited.
-          for (Play play : legal) {
-            if (this_state.get_height(play.end) == MAX_HEIGHT - 1) {
-              visited_states.emplace(get_next_state(this_state, play));
-            }
-          }
-          break;
-        }
-        // If we get here, no immediate winning move was found.
-      }
-
-      double total = 0.0;
-      bool all_seen = true;
-      State next_state;
-      SmallVec<Counts, MAX_LEGAL_MOVES> play_counts;
-      for (const Play &play : legal) {
-        next_state = get_next_state(this_state, play);
-        auto iter = state_counts_.find(next_state);
-        if (iter == state_counts_.end()) {
-          all_seen = false;
-          break;
-        }
-        play_counts.push_back(iter->second);
-        total += iter->second.plays;
-      }
-      if (all_seen) {
-        double log_total = log(total);
-        double best_score = -1;
-        for (int i = 0; i < legal.size(); ++i) {
-          Play play = legal[i];
-          Counts counts = play_counts[i];
-          State s = get_next_state(this_state, play);
-          double score =
-              counts.wins / counts.plays + sqrt(2 * log_total / counts.plays);
-          if (score > best_score) {
-            best_score = score;
-            next_state = s;
-          }
-        }
+  const double lower = log(0.05 / (1 - 0.05));
+  const double upper = log((1 - 0.05) / 0.05);
+  MatchResult result;
+  const char *verdict = "inconclusive";
+  mutex result_mutex;
+  atomic<bool> stopped(false);
+  ThreadPool pool(threads);
+  WorkStealingQueue queue(pairs, pool.size());
+  pool.run([&](int worker) {
+    int pair;
+    while (!stopped.load() && queue.pop(worker, &pair)) {
+      const State &opening = openings[pair % openings.size()];
+      int wins = 0;
+      for (int a_color = 0; a_color < 2; ++a_color) {
+        uint64_t seed = 2 * uint64_t(pair) + a_color;
+        unique_ptr<Player> a = make_player(spec_a, seed);
+        unique_ptr<Player> b = make_player(spec_b, seed);
+        // What the players report as they search would be noise here.
+        a->set_log(nullptr);
+        b->set_log(nullptr);
+        State state = opening;
+        int winner = a_color ? play_game(&state, b.get(), a.get())
+                             : play_game(&state, a.get(), b.get());
+        wins += winner == a_color;
+      }
+      lock_guard<mutex> lock(result_mutex);
+      if (stopped.load()) {
+        break;
       }
+      result.games += 2;
+      result.wins += wins;
+      double margin;
+      double elo = result.elo(&margin);
+      double llr = result.llr(elo0, elo1);
+      printf("%d games: %d-%d, elo %+.1f +- %.1f, llr %.2f (%.2f, %.2f)\n",
+             result.games, result.wins, result.games - result.wins, elo,
+             margin, llr, lower, upper);
+      if (llr >= upper || llr <= lower) {
+        verdict = llr >= upper ? "H1 accepted" : "H0 accepted";
+        stopped.store(true);
+      }
+    }
+  });
+
+  double margin;
+  double elo = result.elo(&margin);
+  printf("%s vs %s: %d games, %d-%d, elo %+.1f +- %.1f, SPRT(%g, %g) %s\n",
+         spec_a.c_str(), spec_b.c_str(), result.games, result.wins,
+         result.games - result.wins, elo, margin, elo0, elo1, verdict);
+  return true;
+}
 
-      this_state = next_state;
-
-      if (expand && !all_seen) {
-        expand = false;
-        Counts counts(0, 0);
-        state_counts_.emplace(this_state, counts);
-        if (t > max_depth_) {
-          max_depth_ = t;
+// Reads the position from a "position" command's words after the first:
+//
+//   startpos [moves m...]
+//   pawns x0 y0 x1 y1 x2 y2 x3 y3 [moves m...]
+//   key k [moves m...]
+//
+// where pawns are given as in starting_positions.txt, k is a
+// packed_to_string key and the moves are as play_to_text writes them.
+// Returns false, leaving *state alone, if they don't make a valid one, with
+// every pawn on its own cell and none on a dome.
+bool parse_position(istringstream *words, State *state) {
+  string word;
+  *words >> word;
+  State position = get_start_state();
+  if (word == "pawns") {
+    Position p[2][PAWN_COUNT];
+    for (int player = 0; player < 2; ++player) {
+      for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+        Position &cell = p[player][pawn];
+        if (!(*words >> cell.x >> cell.y) || cell.x < 0 ||
+            cell.x >= BOARD_WIDTH || cell.y < 0 || cell.y >= BOARD_WIDTH) {
+          return false;
         }
       }
-
-      visited_states.emplace(this_state);
-
-      winner = get_winner(this_state);
-      if (winner >= 0) {
-        break;
-      }
     }
-
-    for (const State &visited_state : visited_states) {
-      auto iter = state_counts_.find(visited_state);
-      if (iter == state_counts_.end()) {
-        continue;
-      }
-      iter->second.plays++;
-      if (visited_state.player != winner) {
-        iter->second.wins++;
-      }
+    memcpy(position.position, p, sizeof(p));
+    position.sync();
+    if (!pawns_are_valid(position)) {
+      return false;
     }
-  }
-
-  void erase_early_states(const State &state) {
-    cout << "Before erase: state_counts_.size() == " << state_counts_.size()
-         << ".\n";
-    for (auto iter = state_counts_.begin(); iter != state_counts_.end();) {
-      if (!iter->first.heights_can_happen_given(state)) {
-        iter = state_counts_.erase(iter);
-      } else {
-        ++iter;
-      }
+  } else if (word == "key") {
+    PackedState key;
+    if (!(*words >> word) || !packed_from_string(word, &key) ||
+        !unpack_state(key, &position)) {
+      return false;
     }
-    cout << "After erase: state_counts_.size() == " << state_counts_.size()
-         << ".\n";
+  } else if (word != "startpos") {
+    return false;
   }
-
-  chrono::milliseconds time_limit_;
-  int max_depth_;
-  unordered_map<State, Counts> state_counts_;
-};
-
-// Plays the game with the state as the starting state and the scratch space.
-//
-// Returns the index of the winning player (either 0 or 1).
-template <bool verbose = false, typename P0, typename P1>
-int play_game(State *state, P0 *p0, P1 *p1) {
-  for (int move_number = 0;; ++move_number) {
-    if (verbose) {
-      printf("Move %2d\n", move_number);
-    }
-    Plays plays = get_legal_plays(*state);
-    if (!plays.size()) {
-      // Next player loses because they have no legal moves.
-      if (verbose) {
-        printf("Player %d wins because player %d has no legal moves.\n",
-               1 - state->player, state->player);
-      }
-      return 1 - state->player;
+  if (*words >> word) {
+    if (word != "moves") {
+      return false;
     }
-    int index = state->player ? p1->select_move(*state, plays)
-                              : p0->select_move(*state, plays);
-    Play play = plays[index];
-    if (state->get_height(play.end) == MAX_HEIGHT - 1) {
-      // Next player wins because they stepped to the winning height.
-      int winner = state->player;
-      if (verbose) {
-        printf("Player %d wins by stepping onto (%d,%d)\n", state->player,
-               play.end.x, play.end.y);
-        *state = get_next_state(*state, play);
-        print_state(*state);
+    while (*words >> word) {
+      Play play;
+      if (!play_from_text(word, position, &play)) {
+        return false;
       }
-      return winner;
-    }
-    if (verbose) {
-      printf("Player %d moves pawn %d to (%d,%d) and builds at (%d,%d)\n",
-             state->player, play.pawn, play.end.x, play.end.y, play.build.x,
-             play.build.y);
-    }
-    // Update board due to selected move.
-    *state = get_next_state(*state, play);
-    if (verbose) {
-      print_state(*state);
+      make_play(&position, play);
     }
   }
+  *state = position;
+  return true;
 }
 
-class SimpleRolloutPlayer : public SimplePlayer {
-public:
-  SimpleRolloutPlayer(std::chrono::milliseconds time_limit, unsigned int seed)
-      : SimplePlayer(seed), time_limit_(time_limit) {}
-
-  int select_move(const State &state, const Plays &plays) {
-    std::chrono::system_clock clock;
-    const auto start_time = clock.now();
-
-    int obvious = get_obvious_move(state, plays);
-    if (obvious >= 0) {
-      return obvious;
-    }
-
-    auto blunders = get_blunders(state, plays);
-    if (blunders.size() == plays.size()) {
-      // All the moves are losers, so just pick the first one,
-      // you loser.
-      return 0;
-    }
-
-    // Collect moves that aren't blunders.
-    SmallVec<Node, MAX_LEGAL_MOVES> nodes;
-    int blunder_index = 0;
-    for (int i = 0; i < plays.size(); ++i) {
-      if (blunders.size() && i == blunders[blunder_index]) {
-        ++blunder_index;
-        continue;
-      }
-      Node node;
-      node.index = i;
-      node.wins = 0;
-      node.visits = 0;
-      nodes.push_back(node);
-    }
-
-    uniform_int_distribution<unsigned int> seed_dist;
-    SimplePlayer player_object(seed_dist(rng_));
-    double rollout_count = 0;
-    for (int n = 0;; n = (n + 1) % nodes.size()) {
-      // Keep going until time expires.
-      if (clock.now() - start_time > time_limit_) {
-        break;
-      }
-      // Play games from here using SimplePlayer for both sides.
-      Play play = plays[nodes[n].index];
-      State next_state = get_next_state(state, play);
-      for (int trial = 0; trial < 100;
-           ++trial, ++rollout_count, ++nodes[n].visits) {
-        State rollout_state = next_state;
-        int winner = play_game(&rollout_state, &player_object, &player_object);
-        nodes[n].wins += (winner == state.player) ? 1 : 0;
-      }
-    }
-    std::printf("Rollout count = %.0f\n", rollout_count);
-
-    int best_index = -1;
-    double best_ratio = std::numeric_limits<double>::lowest();
-    for (const auto &node : nodes) {
-      double ratio = static_cast<double>(node.wins) / node.visits;
-      if (ratio > best_ratio) {
-        best_ratio = ratio;
-        best_index = node.index;
-      }
+// Serves searches over a line protocol on stdin and stdout, in the manner
+// of UCI, so that one process can answer many queries. A single MonteCarlo
+// lives for the whole session, so following a game with "position ...
+// moves" keeps the tree from the last search.
+//
+//   uci                  replies "id name santorini" and uciok
+//   isready              replies readyok, even while searching
+//   position ...         sets the position, as parse_position reads it
+//   go [movetime N] [nodes N]
+//                        searches the position in the background, for at
+//                        most N ms or about N simulations, or else until
+//                        stop, then replies "info ..." and "bestmove m"
+//   stop                 ends the search
+//   stats                replies "stats" and the telemetry JSON of the
+//                        last search
+//   quit
+//
+// Any other command, or one that can't be read, gets "info string error".
+// So does position, go or stats while a search is running, so that the
+// stop for it is never stuck behind them.
+void run_engine(int threads, size_t memory_bytes) {
+  MonteCarlo<true> player(chrono::milliseconds(1000), threads, memory_bytes);
+  atomic<bool> stop(false);
+  player.set_stop_request(&stop);
+  ostringstream telemetry;
+  player.set_telemetry(&telemetry);
+  // Its progress reports aren't part of the protocol.
+  player.set_log(nullptr);
+
+  State state = get_start_state();
+  string stats = "{}";
+  mutex stats_mutex;
+  // Set from go until the search has replied, after which the thread only
+  // has to exit.
+  atomic<bool> searching(false);
+  thread search;
+  auto finish_search = [&]() {
+    if (search.joinable()) {
+      search.join();
     }
-    std::printf("Best ratio = %f\n", best_ratio);
-    return best_index;
-  }
-
-private:
-  struct Node {
-    int index;
-    int wins;
-    int visits;
   };
 
-  std::chrono::milliseconds time_limit_;
-};
-
-class HumanPlayer {
-public:
-  int select_move(const State &state, const Plays &plays) {
-    // print_state(state);
-    string player_label = state.player ? "b" : "a";
-    string expected_pawns[] = {player_label + "0", player_label + "1"};
-    int pawn;
-    Position end;
-    Position build;
-    while (true) {
-      string input;
-
-      // Get pawn.
-      pawn = 0;
-      while (true) {
-        cout << "Which pawn will you move (" << expected_pawns[0] << " or "
-             << expected_pawns[1] << ")\n> ";
-        cin >> input;
-        if (input != expected_pawns[0] && input != expected_pawns[1]) {
-          cout << "Invalid pawn selection, please enter " << expected_pawns[0]
-               << " or " << expected_pawns[1] << ".\n";
-          continue;
-        }
-        if (input == expected_pawns[1]) {
-          pawn = 1;
-        }
-        break;
-      }
-      bool valid_pawn = false;
-      for (int i = 0; i < plays.size(); ++i) {
-        if (plays[i].pawn == pawn) {
-          valid_pawn = true;
-          break;
+  string line;
+  while (getline(cin, line)) {
+    istringstream words(line);
+    string command;
+    if (!(words >> command)) {
+      continue;
+    }
+    if (command == "uci") {
+      printf("id name santorini\nuciok\n");
+    } else if (command == "isready") {
+      printf("readyok\n");
+    } else if (command == "stop") {
+      stop.store(true);
+      finish_search();
+    } else if (command == "quit") {
+      break;
+    } else if ((command == "position" || command == "go" ||
+                command == "stats") &&
+               searching.load()) {
+      printf("info string error: searching\n");
+    } else if (command == "position") {
+      if (!parse_position(&words, &state)) {
+        printf("info string error: bad position\n");
+      }
+    } else if (command == "go") {
+      // Any earlier search has replied, so this doesn't wait.
+      finish_search();
+      // A day stands in for no time limit.
+      chrono::milliseconds time_limit = chrono::hours(24);
+      int64_t nodes = 0;
+      string option;
+      bool ok = true;
+      while (ok && words >> option) {
+        int64_t value;
+        ok = (option == "movetime" || option == "nodes") && words >> value &&
+             value > 0;
+        if (ok && option == "movetime") {
+          time_limit = chrono::milliseconds(value);
+        } else if (ok) {
+          nodes = value;
         }
       }
-      if (!valid_pawn) {
-        cout << "Pawn " << expected_pawns[pawn] << " has no valid moves, "
-             << "please select the other pawn.\n";
-        continue;
-      }
-
-      // Get end.
-      Position start = state.position[state.player][pawn];
-      while (true) {
-        cout << "Which direction will you move\n> ";
-        char direction;
-        cin >> direction;
-        end = get_new_position(start, direction);
-        if (end.x < 0) {
-          cout << "Invalid move direction\n";
-          continue;
-        }
-        bool valid_move = false;
-        for (int i = 0; i < plays.size(); ++i) {
-          if (plays[i].pawn == pawn && plays[i].end == end) {
-            valid_move = true;
-            break;
+      if (!ok) {
+        printf("info string error: bad go\n");
+      } else if (get_winner(state) >= 0) {
+        printf("bestmove none\n");
+      } else {
+        player.set_time_manager(TimeManager::hard_limit(time_limit));
+        player.set_simulation_limit(nodes);
+        stop.store(false);
+        searching.store(true);
+        search = thread([&, state]() {
+          Play play = player.get_next_play(state);
+          string json = telemetry.str();
+          if (!json.empty() && json.back() == '\n') {
+            json.pop_back();
           }
-        }
-        if (!valid_move) {
-          cout << "That move is not legal for that pawn. "
-                  "Try again.\n";
-          continue;
-        }
-        break;
-      }
-
-      // Get build.
-      while (true) {
-        cout << "Which direction will you build\n> ";
-        char direction;
-        cin >> direction;
-        build = get_new_position(end, direction);
-        if (build.x < 0) {
-          cout << "Invalid build direction\n";
-          continue;
-        }
-        for (int i = 0; i < plays.size(); ++i) {
-          if (plays[i].pawn == pawn && plays[i].end == end &&
-              plays[i].build == build) {
-            return i;
+          telemetry.str("");
+          {
+            lock_guard<mutex> lock(stats_mutex);
+            stats = json;
           }
-        }
-        cout << "That build is not legal for that pawn "
-             << "and that move. Try again.\n";
-      }
-    }
-  }
-
-private:
-  Position get_new_position(const Position &start, char entry) {
-    Position end;
-    switch (entry) {
-    case '1': // fall-through.
-    case 'z':
-      end.x = start.x - 1;
-      end.y = start.y + 1;
-      break;
-    case '2': // fall-through.
-    case 'x':
-      end.x = start.x;
-      end.y = start.y + 1;
-      break;
-    case '3': // fall-through.
-    case 'c':
-      end.x = start.x + 1;
-      end.y = start.y + 1;
-      break;
-    case '4': // fall-through.
-    case 'a':
-      end.x = start.x - 1;
-      end.y = start.y;
-      break;
-    case '6': // fall-through.
-    case 'd':
-      end.x = start.x + 1;
-      end.y = start.y;
-      break;
-    case '7': // fall-through.
-    case 'q':
-      end.x = start.x - 1;
-      end.y = start.y - 1;
-      break;
-    case '8': // fall-through.
-    case 'w':
-      end.x = start.x;
-      end.y = start.y - 1;
-      break;
-    case '9': // fall-through.
-    case 'e':
-      end.x = start.x + 1;
-      end.y = start.y - 1;
-      break;
-    default:
-      end.x = -1;
-      end.y = -1;
-    }
-    return end;
-  }
-};
-
-void ref_games(unsigned int seed) {
-  printf("Seed = %u\n", seed);
-  mt19937 rng(seed);
-
-  int counts[2] = {0, 0};
-  MonteCarlo<true> player0(chrono::seconds(10));
-  MonteCarlo<true> player1(chrono::seconds(10));
-  for (int trial = 0; trial < 1; ++trial) {
-    State state = get_start_state();
-    print_state(state);
-    printf("\n");
-    int winner = play_game<true>(&state, &player0, &player1);
-    ++counts[winner];
-    printf("Trial %3d won by player %d (%d to %d).\n", trial, winner, counts[0],
-           counts[1]);
-  }
-  printf("\nPlayer 0 wins %d times, player 1 wins %d times.\n", counts[0],
-         counts[1]);
-}
-
-void evaluate_starting_positions() {
-  fstream fs("starting_positions.txt", fstream::in);
-  for (int i = 0; fs; ++i) {
-    State state = get_start_state();
-    fs
-      >> state.position[0][0].x >> state.position[0][0].y
-      >> state.position[0][1].x >> state.position[0][1].y
-      >> state.position[1][0].x >> state.position[1][0].y
-      >> state.position[1][1].x >> state.position[1][1].y;
-
-    MonteCarlo<true> player(chrono::minutes(2));
-    // TODO: Get victory percentage.
-    player.get_next_play(state);
+          const SearchStats &last = player.last_search();
+          char info[160];
+          snprintf(info, sizeof(info),
+                   "info simulations %lld seconds %.3f win_percent %.4f "
+                   "max_depth %d proven %d",
+                   static_cast<long long>(last.games), last.seconds,
+                   last.win_percent, last.max_depth, last.proven);
+          // Ready for the next command before the client hears it can send
+          // one.
+          searching.store(false);
+          printf("%s\nbestmove %s\n", info, play_to_text(play).c_str());
+          fflush(stdout);
+        });
+      }
+    } else if (command == "stats") {
+      lock_guard<mutex> lock(stats_mutex);
+      printf("stats %s\n", stats.c_str());
+    } else {
+      printf("info string error: unknown command %s\n", command.c_str());
+    }
+    fflush(stdout);
   }
+  stop.store(true);
+  finish_search();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
 //  random_device random_device;
 //  unsigned int seed = argc > 1 ? stoul(argv[1]) : random_device();
 
-  evaluate_starting_positions();
+  string mode = argc > 1 ? argv[1] : "sweep";
+  if (mode == "scaling") {
+    int max_threads = argc > 2 ? stoi(argv[2]) : thread::hardware_concurrency();
+    report_thread_scaling(max(max_threads, 1), chrono::seconds(5));
+  } else if (mode == "sweep") {
+    // santorini sweep [results_file [ms_per_position [threads [memory_mb]]]]
+    string results_path =
+        argc > 2 ? argv[2] : "starting_positions_results.txt";
+    int ms = argc > 3 ? stoi(argv[3]) : 120000;
+    int threads = argc > 4 ? stoi(argv[4]) : thread::hardware_concurrency();
+    size_t memory_mb = argc > 5 ? stoul(argv[5]) : 4096;
+    evaluate_starting_positions(results_path, chrono::milliseconds(ms),
+                                max(threads, 1), memory_mb << 20);
+  } else if (mode == "match") {
+    // santorini match [games [ms_per_move [ms_per_game]]]
+    int games = argc > 2 ? stoi(argv[2]) : 10;
+    int ms = argc > 3 ? stoi(argv[3]) : 1000;
+    int game_ms = argc > 4 ? stoi(argv[4]) : 0;
+    play_negamax_match(games, chrono::milliseconds(ms),
+                       chrono::milliseconds(game_ms));
+  } else if (mode == "book") {
+    // santorini book book_file results_file...
+    if (argc < 4) {
+      fprintf(stderr, "Usage: %s book book_file results_file...\n", argv[0]);
+      return 1;
+    }
+    if (!build_book(argv[2], vector<string>(argv + 3, argv + argc))) {
+      fprintf(stderr, "Can't write %s\n", argv[2]);
+      return 1;
+    }
+  } else if (mode == "tournament") {
+    // santorini tournament player_a player_b [games [threads [elo0 elo1]]]
+    if (argc < 4) {
+      fprintf(stderr,
+              "Usage: %s tournament player_a player_b "
+              "[games [threads [elo0 elo1]]]\n",
+              argv[0]);
+      return 1;
+    }
+    int games = argc > 4 ? stoi(argv[4]) : 1000;
+    int threads = argc > 5 ? stoi(argv[5]) : thread::hardware_concurrency();
+    double elo0 = argc > 7 ? stod(argv[6]) : 0;
+    double elo1 = argc > 7 ? stod(argv[7]) : 10;
+    if (!run_tournament(argv[2], argv[3], games, max(threads, 1), elo0,
+                        elo1)) {
+      return 1;
+    }
+  } else if (mode == "engine") {
+    // santorini engine [threads [memory_mb]]
+    int threads = argc > 2 ? stoi(argv[2]) : thread::hardware_concurrency();
+    size_t memory_mb = argc > 3 ? stoul(argv[3]) : 1024;
+    run_engine(max(threads, 1), memory_mb << 20);
+  } else if (mode == "ref") {
+    // santorini ref [book_file]
+    OpeningBook book;
+    if (argc > 2 && !book.open(argv[2])) {
+      fprintf(stderr, "Can't read book %s\n", argv[2]);
+      return 1;
+    }
+    random_device random_device;
+    ref_games(random_device(), argc > 2 ? &book : nullptr);
+  } else {
+    fprintf(stderr, "Unknown mode %s\n", mode.c_str());
+    return 1;
+  }
 }
@@ -0,0 +1,4008 @@
+#ifndef SANTORINI_H
+#define SANTORINI_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <immintrin.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef SANTORINI_COUNT_ALLOCATIONS
+// Debug builds count every heap allocation, per thread, so hot loops can
+// assert that they make none. This replaces the global operator new, so it
+// must only be compiled into one translation unit per program. Both
+// operators stay out of line, or GCC sees malloc paired with delete.
+inline uint64_t &thread_allocations() {
+  static thread_local uint64_t count = 0;
+  return count;
+}
+
+__attribute__((noinline)) void *operator new(size_t size) {
+  ++thread_allocations();
+  void *p = malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  free(p);
+}
+#endif
+
+// Everything below is in santorini::detail, the implementation behind the
+// library's engine.h. Programs built on it directly, like santorini and
+// bench, bring it in with using-directives in their own source.
+namespace santorini {
+namespace detail {
+
+// The board is a 5x5 square of cells.
+constexpr int BOARD_WIDTH = 5;
+
+// Each player has 2 pawns.
+constexpr int PAWN_COUNT = 2;
+
+// Maximum height for each cell.
+constexpr int MAX_HEIGHT = 4;
+
+// Each pawn could have 8 places to move and then 8 places to build;
+constexpr int MAX_LEGAL_MOVES = PAWN_COUNT * 8 * 8;
+
+// A vector with a maximum length of N.
+//
+// It doesn't do checks for you though, so it's up to you not to overfill it.
+template <typename T, int N> class SmallVec {
+public:
+  SmallVec() : length_(0) {}
+
+  void push_back(const T &val) {
+    values_[length_] = val;
+    ++length_;
+  }
+
+  T &operator[](int n) { return values_[n]; }
+  const T &operator[](int n) const { return values_[n]; }
+  T *begin() { return values_; }
+  T *end() { return values_ + length_; }
+  const T *begin() const { return values_; }
+  const T *end() const { return values_ + length_; }
+  int size() const { return length_; }
+
+private:
+  int length_;
+  T values_[N];
+};
+
+struct Position {
+  int x;
+  int y;
+
+  Position() {}
+  Position(int x, int y) : x(x), y(y) {}
+
+  bool operator==(const Position &that) const {
+    return that.x == x && that.y == y;
+  }
+
+  bool operator!=(const Position &that) const { return !(*this == that); }
+};
+
+// The cells of the board are numbered y * BOARD_WIDTH + x.
+constexpr int CELL_COUNT = BOARD_WIDTH * BOARD_WIDTH;
+
+// Every play builds a level and there are only so many levels to build, so
+// no game is longer than this.
+constexpr int MAX_GAME_PLIES = CELL_COUNT * MAX_HEIGHT;
+
+// A set of cells with one bit per cell.
+using Bitboard = uint32_t;
+
+constexpr Bitboard BOARD_MASK = (Bitboard(1) << CELL_COUNT) - 1;
+
+// The cells adjacent to each cell, including diagonals.
+constexpr Bitboard NEIGHBORS[CELL_COUNT] = {
+    0x0000062, 0x00000e5, 0x00001ca, 0x0000394, 0x0000308,
+    0x0000c43, 0x0001ca7, 0x000394e, 0x000729c, 0x0006118,
+    0x0018860, 0x00394e0, 0x00729c0, 0x00e5380, 0x00c2300,
+    0x0310c00, 0x0729c00, 0x0e53800, 0x1ca7000, 0x1846000,
+    0x0218000, 0x0538000, 0x0a70000, 0x14e0000, 0x08c0000,
+};
+
+inline int cell_index(const Position &p) { return p.y * BOARD_WIDTH + p.x; }
+
+inline Position cell_position(int cell) {
+  return Position(cell % BOARD_WIDTH, cell / BOARD_WIDTH);
+}
+
+inline Bitboard cell_bit(int cell) { return Bitboard(1) << cell; }
+
+inline Bitboard cell_bit(const Position &p) { return cell_bit(cell_index(p)); }
+
+// Removes the lowest cell from a non-empty set and returns its index.
+inline int pop_cell(Bitboard *cells) {
+  int cell = __builtin_ctz(*cells);
+  *cells &= *cells - 1;
+  return cell;
+}
+
+// Random keys for Zobrist hashing. The hash of a state is the XOR of the keys
+// for each cell's height, each player's pawn cells and the player to move,
+// so a play only has to XOR in the keys that change.
+struct ZobristKeys {
+  uint64_t height[CELL_COUNT][MAX_HEIGHT + 1]; // height[c][0] is zero.
+  uint64_t pawn[2][CELL_COUNT];                // First index is player.
+  uint64_t player;                             // Set when player 1 moves.
+
+  ZobristKeys() {
+    // splitmix64 with a fixed seed, so hashes are stable from run to run.
+    uint64_t seed = 0x5a4e70121e5a4e70ULL;
+    auto next = [&seed]() {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    };
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+      height[cell][0] = 0;
+      for (int h = 1; h <= MAX_HEIGHT; ++h) {
+        height[cell][h] = next();
+      }
+    }
+    for (int p = 0; p < 2; ++p) {
+      for (int cell = 0; cell < CELL_COUNT; ++cell) {
+        pawn[p][cell] = next();
+      }
+    }
+    player = next();
+  }
+};
+
+const ZobristKeys ZOBRIST;
+
+struct State {
+  int player;
+  Position position[2][PAWN_COUNT]; // First index is player.
+  // Bit c of levels[h] is set when cell c is higher than h, so the cells of
+  // height exactly h are levels[h - 1] & ~levels[h] and the domes are
+  // levels[MAX_HEIGHT - 1].
+  Bitboard levels[MAX_HEIGHT];
+  Bitboard pawns[2]; // Cells occupied by each player's pawns.
+  // Zobrist hash of everything above. Pawns of the same player are
+  // interchangeable in it, so swapping their indices keeps the hash.
+  uint64_t hash;
+
+  bool operator==(const State &that) const {
+    return 0 == memcmp(this, &that, sizeof(that));
+  }
+
+  int get_height(int cell) const {
+    return ((levels[0] >> cell) & 1) + ((levels[1] >> cell) & 1) +
+           ((levels[2] >> cell) & 1) + ((levels[3] >> cell) & 1);
+  }
+
+  int get_height(const Position &p) const { return get_height(cell_index(p)); }
+
+  int get_height(int player, int pawn) const {
+    return get_height(position[player][pawn]);
+  }
+
+  int increment_height(const Position &p) {
+    int cell = cell_index(p);
+    int h = get_height(cell);
+    levels[h] |= cell_bit(cell);
+    hash ^= ZOBRIST.height[cell][h] ^ ZOBRIST.height[cell][h + 1];
+    return h + 1;
+  }
+
+  // The cells whose height is at most h.
+  Bitboard cells_at_most(int h) const {
+    return h < MAX_HEIGHT ? ~levels[h] & BOARD_MASK : BOARD_MASK;
+  }
+
+  // The cells whose height is exactly h.
+  Bitboard cells_at(int h) const {
+    return (h ? levels[h - 1] : BOARD_MASK) & cells_at_most(h);
+  }
+
+  Bitboard occupied() const { return pawns[0] | pawns[1]; }
+
+  // Cells that a pawn could move to or build on, ignoring height.
+  Bitboard open_cells() const {
+    return ~(occupied() | levels[MAX_HEIGHT - 1]) & BOARD_MASK;
+  }
+
+  void place_pawn(int player, int pawn, const Position &p) {
+    int from = cell_index(position[player][pawn]);
+    int to = cell_index(p);
+    pawns[player] ^= cell_bit(from) | cell_bit(to);
+    hash ^= ZOBRIST.pawn[player][from] ^ ZOBRIST.pawn[player][to];
+    position[player][pawn] = p;
+  }
+
+  void set_player(int p) {
+    if (p != player) {
+      hash ^= ZOBRIST.player;
+    }
+    player = p;
+  }
+
+  // Recomputes the occupancy masks and the hash after position has been
+  // set directly.
+  void sync() {
+    hash = player ? ZOBRIST.player : 0;
+    for (int p = 0; p < 2; ++p) {
+      pawns[p] = 0;
+      for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+        int cell = cell_index(position[p][pawn]);
+        pawns[p] |= cell_bit(cell);
+        hash ^= ZOBRIST.pawn[p][cell];
+      }
+    }
+    for (int cell = 0; cell < CELL_COUNT; ++cell) {
+      hash ^= ZOBRIST.height[cell][get_height(cell)];
+    }
+  }
+
+  bool is_pawn_at(const Position &p) const {
+    return occupied() & cell_bit(p);
+  }
+
+  bool is_blocked(const Position &p) const {
+    return ~open_cells() & cell_bit(p);
+  }
+};
+
+struct Play {
+  int pawn;
+  Position end;
+  Position build;
+
+  bool operator==(const Play &that) const {
+    return pawn == that.pawn && end == that.end && build == that.build;
+  }
+};
+
+using Plays = SmallVec<Play, MAX_LEGAL_MOVES>;
+
+// A State squeezed into two words, for keys in tables and files.
+//
+// The low word holds 3 bits of height for cells 0 to 20. The high word
+// holds the heights of cells 21 to 24, then 5 bits for each pawn's cell in
+// the same order as State::position, then the player to move.
+struct PackedState {
+  uint64_t lo;
+  uint64_t hi;
+
+  bool operator==(const PackedState &that) const {
+    return lo == that.lo && hi == that.hi;
+  }
+
+  bool operator!=(const PackedState &that) const { return !(*this == that); }
+
+  bool operator<(const PackedState &that) const {
+    return hi != that.hi ? hi < that.hi : lo < that.lo;
+  }
+
+  uint64_t hash() const {
+    uint64_t h = (lo ^ (hi << 32 | hi >> 32)) * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 29);
+  }
+};
+
+constexpr int PACKED_HEIGHT_BITS = 3;
+constexpr int PACKED_LO_CELLS = 64 / PACKED_HEIGHT_BITS;
+constexpr int PACKED_PAWN_BITS = 5;
+constexpr int PACKED_PAWN_SHIFT =
+    (CELL_COUNT - PACKED_LO_CELLS) * PACKED_HEIGHT_BITS;
+constexpr int PACKED_PLAYER_SHIFT =
+    PACKED_PAWN_SHIFT + 2 * PAWN_COUNT * PACKED_PAWN_BITS;
+static_assert(PACKED_PLAYER_SHIFT < 64, "State doesn't fit in 128 bits");
+
+// Whether the four pawns stand on different cells, none of them a dome, as
+// they must for get_legal_plays and the rest. The pawns must be synced.
+inline bool pawns_are_valid(const State &state) {
+  return __builtin_popcount(state.occupied()) == 2 * PAWN_COUNT &&
+         !(state.occupied() & state.levels[MAX_HEIGHT - 1]);
+}
+
+inline PackedState pack_state(const State &state) {
+  PackedState packed;
+  packed.lo = packed.hi = 0;
+  for (int cell = 0; cell < CELL_COUNT; ++cell) {
+    uint64_t h = state.get_height(cell);
+    if (cell < PACKED_LO_CELLS) {
+      packed.lo |= h << (cell * PACKED_HEIGHT_BITS);
+    } else {
+      packed.hi |= h << ((cell - PACKED_LO_CELLS) * PACKED_HEIGHT_BITS);
+    }
+  }
+  int shift = PACKED_PAWN_SHIFT;
+  for (int player = 0; player < 2; ++player) {
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      packed.hi |= uint64_t(cell_index(state.position[player][pawn])) << shift;
+      shift += PACKED_PAWN_BITS;
+    }
+  }
+  packed.hi |= uint64_t(state.player) << PACKED_PLAYER_SHIFT;
+  return packed;
+}
+
+// Unpacks a key written by pack_state. Returns false, leaving *state alone,
+// for a key that no valid board packs to: one with a height over
+// MAX_HEIGHT, a pawn off the board, on a dome or on another pawn's cell, or
+// a bit set past the player.
+inline bool unpack_state(const PackedState &packed, State *state) {
+  if (packed.lo >> (PACKED_LO_CELLS * PACKED_HEIGHT_BITS) ||
+      packed.hi >> (PACKED_PLAYER_SHIFT + 1)) {
+    return false;
+  }
+  State result = State();
+  const uint64_t height_mask = (1 << PACKED_HEIGHT_BITS) - 1;
+  for (int cell = 0; cell < CELL_COUNT; ++cell) {
+    int h = cell < PACKED_LO_CELLS
+                ? (packed.lo >> (cell * PACKED_HEIGHT_BITS)) & height_mask
+                : (packed.hi >> ((cell - PACKED_LO_CELLS) *
+                                 PACKED_HEIGHT_BITS)) & height_mask;
+    if (h > MAX_HEIGHT) {
+      return false;
+    }
+    for (int level = 0; level < h; ++level) {
+      result.levels[level] |= cell_bit(cell);
+    }
+  }
+  int shift = PACKED_PAWN_SHIFT;
+  for (int player = 0; player < 2; ++player) {
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      int cell = (packed.hi >> shift) & ((1 << PACKED_PAWN_BITS) - 1);
+      if (cell >= CELL_COUNT) {
+        return false;
+      }
+      result.position[player][pawn] = cell_position(cell);
+      shift += PACKED_PAWN_BITS;
+    }
+  }
+  result.player = (packed.hi >> PACKED_PLAYER_SHIFT) & 1;
+  result.sync();
+  if (!pawns_are_valid(result)) {
+    return false;
+  }
+  *state = result;
+  return true;
+}
+
+// Writes the key as 32 hex digits, high word first.
+inline std::string packed_to_string(const PackedState &packed) {
+  char text[33];
+  snprintf(text, sizeof(text), "%016llx%016llx",
+           static_cast<unsigned long long>(packed.hi),
+           static_cast<unsigned long long>(packed.lo));
+  return text;
+}
+
+// Reads a key written by packed_to_string. Returns false if it isn't one.
+inline bool packed_from_string(const std::string &text, PackedState *packed) {
+  if (text.size() != 32 ||
+      text.find_first_not_of("0123456789abcdef") != std::string::npos) {
+    return false;
+  }
+  packed->hi = std::stoull(text.substr(0, 16), nullptr, 16);
+  packed->lo = std::stoull(text.substr(16), nullptr, 16);
+  return true;
+}
+
+} // namespace detail
+} // namespace santorini
+
+namespace std {
+// We need this so we can use State as the key in an unordered_map.
+template <> struct hash<santorini::detail::State> {
+  size_t operator()(const santorini::detail::State &state) const {
+    return state.hash;
+  }
+};
+
+template <> struct hash<santorini::detail::PackedState> {
+  size_t operator()(const santorini::detail::PackedState &packed) const {
+    return packed.hash();
+  }
+};
+} // namespace std
+
+namespace santorini {
+namespace detail {
+
+inline void print_state(const State &state) {
+  std::cout << "Next player = " << state.player << "\n";
+  char screen[11][26];
+  for (int y = 0; y < 11; ++y) {
+    for (int x = 0; x < 26; ++x) {
+      screen[y][x] = ' ';
+    }
+  }
+  for (int y = 0; y < 5; ++y) {
+    for (int x = 0; x < 5; ++x) {
+      screen[2 * y][5 * x] = '+';
+      screen[2 * y][5 * x + 1] = '-';
+      screen[2 * y][5 * x + 2] = '-';
+      screen[2 * y][5 * x + 3] = '-';
+      screen[2 * y][5 * x + 4] = '-';
+      screen[2 * y + 1][5 * x] = '|';
+      screen[2 * y + 1][5 * x + 1] = '0' + state.get_height(Position(x, y));
+    }
+  }
+  for (int player = 0; player < 2; ++player) {
+    for (int pawn = 0; pawn < 2; ++pawn) {
+      Position p = state.position[player][pawn];
+      screen[2 * p.y + 1][5 * p.x + 2] = ':';
+      screen[2 * p.y + 1][5 * p.x + 3] = player ? 'b' : 'a';
+      screen[2 * p.y + 1][5 * p.x + 4] = '0' + pawn;
+    }
+  }
+  for (int y = 0; y < 11; ++y) {
+    for (int x = 0; x < 26; ++x) {
+      std::cout << screen[y][x];
+    }
+    std::cout << "\n";
+  }
+}
+
+inline State get_start_state() {
+  State state = State();
+  state.position[0][0] = Position(0, 0);
+  state.position[0][1] = Position(4, 4);
+  state.position[1][0] = Position(0, 4);
+  state.position[1][1] = Position(4, 0);
+  state.sync();
+  return state;
+}
+
+// What unmake_play needs to take back a play made with make_play.
+struct Undo {
+  Position start; // Where the moved pawn came from.
+  uint64_t hash;
+};
+
+// Makes the play in place, for searches that walk one board up and down the
+// tree rather than copying a State per ply.
+inline Undo make_play(State *state, const Play &play) {
+  Undo undo;
+  undo.start = state->position[state->player][play.pawn];
+  undo.hash = state->hash;
+  state->place_pawn(state->player, play.pawn, play.end);
+  state->increment_height(play.build);
+  state->set_player(1 - state->player);
+  return undo;
+}
+
+// Takes back the last play made on state, given make_play's undo record.
+inline void unmake_play(State *state, const Play &play, const Undo &undo) {
+  int player = 1 - state->player;
+  int build = cell_index(play.build);
+  state->levels[state->get_height(build) - 1] &= ~cell_bit(build);
+  state->pawns[player] ^= cell_bit(play.end) | cell_bit(undo.start);
+  state->position[player][play.pawn] = undo.start;
+  state->player = player;
+  state->hash = undo.hash;
+}
+
+inline State get_next_state(const State &state, const Play &play) {
+  State result(state);
+  make_play(&result, play);
+  return result;
+}
+
+// The cells the pawn can move to: open neighbors at most one level higher.
+inline Bitboard get_pawn_moves(const State &state, int pawn) {
+  int start = cell_index(state.position[state.player][pawn]);
+  return NEIGHBORS[start] & state.open_cells() &
+         state.cells_at_most(state.get_height(start) + 1);
+}
+
+inline bool has_legal_play(const State &state) {
+  for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+    if (get_pawn_moves(state, pawn)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline Plays get_legal_plays(const State &state) {
+  Plays plays;
+  // The moving pawn's start cell is still occupied here, which keeps it out
+  // of the build masks; it gets pushed explicitly as the first build.
+  Bitboard open = state.open_cells();
+  for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+    Position start = state.position[state.player][pawn];
+    Bitboard ends = get_pawn_moves(state, pawn);
+    while (ends) {
+      int end = pop_cell(&ends);
+      Play play;
+      play.pawn = pawn;
+      play.end = cell_position(end);
+      play.build = start;
+      plays.push_back(play);
+      Bitboard builds = NEIGHBORS[end] & open;
+      while (builds) {
+        play.build = cell_position(pop_cell(&builds));
+        plays.push_back(play);
+      }
+    }
+  }
+  return plays;
+}
+
+inline int get_winner(const State &state) {
+  // Pawns can't stand on domes, so any pawn above MAX_HEIGHT - 2 is on top
+  // of a tower of winning height.
+  for (int player = 0; player < 2; ++player) {
+    if (state.pawns[player] & state.levels[MAX_HEIGHT - 2]) {
+      return player;
+    }
+  }
+  if (!has_legal_play(state)) {
+    return 1 - state.player;
+  }
+  return -1;
+}
+
+// The same as get_winner for a state that play has just been made in, when
+// the game wasn't over before it. Only the moved pawn can have reached the
+// winning height, and only the player to move can be stuck.
+inline int get_winner_after(const State &state, const Play &play) {
+  int mover = 1 - state.player;
+  if (state.levels[MAX_HEIGHT - 2] & cell_bit(play.end)) {
+    return mover;
+  }
+  return has_legal_play(state) ? -1 : mover;
+}
+
+// Checks whether the player to move can step up to the winning height.
+inline bool has_immediate_win(const State &state) {
+  for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+    Position p = state.position[state.player][pawn];
+    if (state.get_height(p) == MAX_HEIGHT - 2) {
+      // This pawn is just below the winning height.
+      //
+      // If it has a neighbor at winning height, then there
+      // is a winning move for the current player.
+      if (NEIGHBORS[cell_index(p)] & state.cells_at(MAX_HEIGHT - 1)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// The board has the 8 symmetries of the square: transform t flips x if bit 0
+// is set, flips y if bit 1 is set and then swaps x and y if bit 2 is set.
+// Transform 0 is the identity.
+constexpr int SYMMETRY_COUNT = 8;
+
+struct SymmetryTables {
+  uint8_t cell[SYMMETRY_COUNT][CELL_COUNT]; // Where each cell goes.
+  uint8_t inverse[SYMMETRY_COUNT];
+  // rows[t][r][bits] is where the cells of row r in bits go under t.
+  Bitboard rows[SYMMETRY_COUNT][BOARD_WIDTH][1 << BOARD_WIDTH];
+
+  SymmetryTables() {
+    const int last = BOARD_WIDTH - 1;
+    for (int t = 0; t < SYMMETRY_COUNT; ++t) {
+      for (int c = 0; c < CELL_COUNT; ++c) {
+        Position p = cell_position(c);
+        int x = t & 1 ? last - p.x : p.x;
+        int y = t & 2 ? last - p.y : p.y;
+        cell[t][c] = t & 4 ? cell_index(Position(y, x))
+                           : cell_index(Position(x, y));
+      }
+    }
+    for (int t = 0; t < SYMMETRY_COUNT; ++t) {
+      for (int u = 0; u < SYMMETRY_COUNT; ++u) {
+        if (cell[u][cell[t][1]] == 1 && cell[u][cell[t][BOARD_WIDTH]] ==
+                                            BOARD_WIDTH) {
+          inverse[t] = u;
+        }
+      }
+      for (int r = 0; r < BOARD_WIDTH; ++r) {
+        for (int bits = 0; bits < 1 << BOARD_WIDTH; ++bits) {
+          rows[t][r][bits] = 0;
+          for (int x = 0; x < BOARD_WIDTH; ++x) {
+            if (bits & (1 << x)) {
+              rows[t][r][bits] |= cell_bit(cell[t][r * BOARD_WIDTH + x]);
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+const SymmetryTables SYMMETRIES;
+
+// Moves every cell in the set to where transform t takes it.
+inline Bitboard transform_cells(Bitboard cells, int t) {
+  const Bitboard(*rows)[1 << BOARD_WIDTH] = SYMMETRIES.rows[t];
+  const Bitboard row = (1 << BOARD_WIDTH) - 1;
+  return rows[0][cells & row] | rows[1][(cells >> 5) & row] |
+         rows[2][(cells >> 10) & row] | rows[3][(cells >> 15) & row] |
+         rows[4][(cells >> 20) & row];
+}
+
+inline Position transform_position(const Position &p, int t) {
+  return cell_position(SYMMETRIES.cell[t][cell_index(p)]);
+}
+
+// Applies transform t to the whole board. Pawns keep their indices.
+inline State transform_state(const State &state, int t) {
+  State result(state);
+  for (int h = 0; h < MAX_HEIGHT; ++h) {
+    result.levels[h] = transform_cells(state.levels[h], t);
+  }
+  for (int player = 0; player < 2; ++player) {
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      result.position[player][pawn] =
+          transform_position(state.position[player][pawn], t);
+    }
+  }
+  result.sync();
+  return result;
+}
+
+// Checks whether transform t takes a to b, treating each player's pawns as
+// interchangeable.
+inline bool is_symmetry(const State &a, const State &b, int t) {
+  if (a.player != b.player) {
+    return false;
+  }
+  for (int h = 0; h < MAX_HEIGHT; ++h) {
+    if (transform_cells(a.levels[h], t) != b.levels[h]) {
+      return false;
+    }
+  }
+  return transform_cells(a.pawns[0], t) == b.pawns[0] &&
+         transform_cells(a.pawns[1], t) == b.pawns[1];
+}
+
+// Returns a transform taking a to b, or -1 if they aren't symmetric.
+inline int find_symmetry(const State &a, const State &b) {
+  for (int t = 0; t < SYMMETRY_COUNT; ++t) {
+    if (is_symmetry(a, b, t)) {
+      return t;
+    }
+  }
+  return -1;
+}
+
+// Returns the representative of the state's symmetry class, which is the
+// same for all 8 orientations of a board, and sets *transform to the
+// transform that takes the state there.
+//
+// The representative is the orientation whose masks compare lowest, with
+// each player's pawns numbered in cell order, so symmetric states get the
+// same hash and the same packed key.
+inline State canonicalize(const State &state, int *transform) {
+  Bitboard best[MAX_HEIGHT + 2] = {};
+  int best_t = 0;
+  for (int t = 0; t < SYMMETRY_COUNT; ++t) {
+    Bitboard masks[MAX_HEIGHT + 2];
+    for (int h = 0; h < MAX_HEIGHT; ++h) {
+      masks[h] = transform_cells(state.levels[MAX_HEIGHT - 1 - h], t);
+    }
+    masks[MAX_HEIGHT] = transform_cells(state.pawns[0], t);
+    masks[MAX_HEIGHT + 1] = transform_cells(state.pawns[1], t);
+    if (!t || std::lexicographical_compare(masks, masks + MAX_HEIGHT + 2, best,
+                                      best + MAX_HEIGHT + 2)) {
+      std::copy(masks, masks + MAX_HEIGHT + 2, best);
+      best_t = t;
+    }
+  }
+  if (transform) {
+    *transform = best_t;
+  }
+  State result = transform_state(state, best_t);
+  for (int player = 0; player < 2; ++player) {
+    Position *p = result.position[player];
+    if (cell_index(p[0]) > cell_index(p[1])) {
+      std::swap(p[0], p[1]);
+    }
+  }
+  return result;
+}
+
+inline PackedState canonical_key(const State &state) {
+  return pack_state(canonicalize(state, nullptr));
+}
+
+// Maps a play in state to the same play in target, where transform t takes
+// state to target. The pawn index comes from target, since the two states
+// may number their pawns differently.
+inline Play transform_play(const State &state, const Play &play, int t,
+                           const State &target) {
+  Position start = transform_position(
+      state.position[state.player][play.pawn], t);
+  Play result;
+  result.pawn = target.position[target.player][0] == start ? 0 : 1;
+  result.end = transform_position(play.end, t);
+  result.build = transform_position(play.build, t);
+  return result;
+}
+
+// Removes plays that lead to the same state as an earlier kept play, up to
+// the symmetries of the state itself. Most states have no symmetry other
+// than the identity, and then this returns all the plays.
+inline Plays get_distinct_plays(const State &state, const Plays &plays) {
+  SmallVec<int, SYMMETRY_COUNT> symmetries;
+  for (int t = 1; t < SYMMETRY_COUNT; ++t) {
+    if (is_symmetry(state, state, t)) {
+      symmetries.push_back(t);
+    }
+  }
+  if (!symmetries.size()) {
+    return plays;
+  }
+  // Keep a play only if no symmetry maps it onto a play that sorts lower,
+  // comparing (start, end, build) cells.
+  Plays distinct;
+  for (const Play &play : plays) {
+    int start = cell_index(state.position[state.player][play.pawn]);
+    auto key =
+        std::make_tuple(start, cell_index(play.end), cell_index(play.build));
+    bool lowest = true;
+    for (int t : symmetries) {
+      const uint8_t *cell = SYMMETRIES.cell[t];
+      if (std::make_tuple(int(cell[start]), int(cell[cell_index(play.end)]),
+                     int(cell[cell_index(play.build)])) < key) {
+        lowest = false;
+        break;
+      }
+    }
+    if (lowest) {
+      distinct.push_back(play);
+    }
+  }
+  return distinct;
+}
+
+// A base for players that report their progress as they search, which
+// they write to *log_.
+class ProgressLog {
+public:
+  ProgressLog() : log_(&std::cout), silent_(nullptr) {}
+
+  // Sends the reports to out instead of cout, or drops them for nullptr.
+  void set_log(std::ostream *out) { log_ = out ? out : &silent_; }
+
+protected:
+  std::ostream *log_;
+
+private:
+  std::ostream silent_; // Has no buffer, so it drops everything.
+};
+
+// Simple AI that looks ahead to the opponent's next move. It reports
+// nothing, but takes a log like the players built on it.
+class SimplePlayer : public ProgressLog {
+public:
+  SimplePlayer(unsigned int seed) : rng_(seed) {}
+
+  int select_move(const State &state, const Plays &plays) {
+    int obvious = get_obvious_move(state, plays);
+    if (obvious >= 0) {
+      return obvious;
+    }
+
+    auto blunders = get_blunders(state, plays);
+    if (blunders.size() == plays.size()) {
+      // All the moves are losers, so just pick the first one,
+      // you loser.
+      return 0;
+    }
+
+    // Choose at random from among the non-losing moves.
+    std::uniform_int_distribution<int> uni(0,
+                                           plays.size() - blunders.size() - 1);
+    int rand = uni(rng_);
+    int skip = rand;
+    int base = 0;
+    for (int blunder : blunders) {
+      if (base + skip < blunder) {
+        return base + skip;
+      }
+      skip -= blunder - base;
+      base = blunder + 1;
+    }
+
+    if (base + skip >= plays.size()) {
+      // It shouldn't be possible to get here.
+      std::fprintf(stderr,
+                   "Couldn't find %d winners from "
+                   "%d moves minus %d losers\n",
+                   rand, plays.size(), blunders.size());
+      std::exit(EXIT_FAILURE);
+    }
+
+    return base + skip;
+  }
+
+protected:
+  int get_obvious_move(const State &state, const Plays &plays) {
+    // First see if any of the moves wins the game.
+    // If so, select that move.
+    for (int i = 0; i < plays.size(); ++i) {
+      Play play = plays[i];
+      if (state.get_height(play.end) == MAX_HEIGHT - 1) {
+        return i;
+      }
+    }
+
+    // Check if a single move stops the other player from winning.
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      Position them = state.position[1 - state.player][pawn];
+      if (state.get_height(them) == MAX_HEIGHT - 2) {
+        // This pawn is at the right height to win on the next move.
+        Bitboard towers = NEIGHBORS[cell_index(them)] &
+                          state.cells_at(MAX_HEIGHT - 1);
+        if (towers) {
+          Position end = cell_position(__builtin_ctz(towers));
+          // This move will win the game for the opponent,
+          // so try to build here. We know we can't move here
+          // because we checked that above.
+          int stopper_index = -1;
+          bool stopper_seen = false;
+          for (int i = 0; i < plays.size(); ++i) {
+            if (plays[i].build == end) {
+              if (stopper_seen) {
+                // More than one way to stop them, so
+                // it's not obvious what to do.
+                return -1;
+              }
+              stopper_seen = true;
+              stopper_index = i;
+            }
+          }
+          if (stopper_seen) {
+            // This stops this particular winning move for
+            // the opponent, but the opponent may have other
+            // winning moves. In any case, we can only stop
+            // one so do not bother checking for others.
+            return stopper_index;
+          } else {
+            // The other user is going to win and we have no
+            // way to stop it, so just give up.
+            return 0;
+          }
+        }
+      }
+    }
+    // No obvious move found, return -1.
+    return -1;
+  }
+
+  SmallVec<int, MAX_LEGAL_MOVES> get_blunders(const State &state,
+                                              const Plays &plays) {
+    SmallVec<int, MAX_LEGAL_MOVES> blunders;
+    // Cells where a tower of winning height could be climbed right away by
+    // an opponent pawn that is close enough, vertically and horizontally.
+    Bitboard danger = 0;
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      Position them = state.position[1 - state.player][pawn];
+      if (state.get_height(them) == MAX_HEIGHT - 2) {
+        danger |= NEIGHBORS[cell_index(them)];
+      }
+    }
+    danger &= state.cells_at(MAX_HEIGHT - 2);
+    if (!danger) {
+      return blunders;
+    }
+    for (int i = 0; i < plays.size(); ++i) {
+      // Building here makes a tower of winning height next to the opponent,
+      // so do not choose this move.
+      if (danger & cell_bit(plays[i].build)) {
+        blunders.push_back(i);
+      }
+    }
+    return blunders;
+  }
+
+  std::mt19937 rng_;
+};
+
+// The number of games a PlayoutBatch plays side by side.
+constexpr int PLAYOUT_LANES = 16;
+
+// The cells next to any cell in the set, and the set itself.
+inline Bitboard dilate(Bitboard cells) {
+  // Cells in the first and last column, which a shift by one wraps into.
+  const Bitboard first_column = 0x0108421;
+  const Bitboard last_column = first_column << (BOARD_WIDTH - 1);
+  Bitboard row = cells | ((cells << 1) & ~first_column) |
+                 ((cells >> 1) & ~last_column);
+  return (row | (row << BOARD_WIDTH) | (row >> BOARD_WIDTH)) & BOARD_MASK;
+}
+
+// Returns the index of the nth lowest cell in the set.
+inline int nth_cell(Bitboard cells, int n) {
+#ifdef __BMI2__
+  return __builtin_ctz(_pdep_u32(Bitboard(1) << n, cells));
+#else
+  while (n--) {
+    cells &= cells - 1;
+  }
+  return __builtin_ctz(cells);
+#endif
+}
+
+// Plays random games with SimplePlayer's policy for both sides, many at once.
+//
+// The games are kept as structure-of-arrays bitboards, one lane per game,
+// and advance in lockstep. Finding immediate wins and blunder cells, moving
+// pawns and raising buildings are loops over the lanes that the compiler
+// turns into SIMD code (SSE2 by default, AVX2 with -march=native). Picking
+// each lane's play stays scalar, but counts plays from masks instead of
+// listing them. A lane whose game ends starts the next one right away.
+class PlayoutBatch {
+public:
+  explicit PlayoutBatch(uint64_t seed) {
+    // Each lane starts at a scrambled point of the sequence, so the lanes
+    // don't replay each other's numbers a few draws apart.
+    for (int i = 0; i < PLAYOUT_LANES; ++i) {
+      rng_[i] = seed + i;
+      rng_[i] = next_random(i);
+    }
+  }
+
+  // Plays games from state and adds the number each player won to wins.
+  void run(const State &state, int games, int wins[2]) {
+    int started = 0;
+    int live = 0;
+    for (int i = 0; i < PLAYOUT_LANES; ++i) {
+      winner_[i] = -1;
+      if (started < games) {
+        reset(i, state);
+        ++started;
+        ++live;
+      } else {
+        // Idle lanes still go through the SIMD loops, so give them a board
+        // that can't do anything.
+        reset(i, state);
+        finished_[i] = true;
+      }
+    }
+    while (live) {
+      find_threats();
+      for (int i = 0; i < PLAYOUT_LANES; ++i) {
+        moved_[i] = built_[i] = 0;
+        if (!finished_[i]) {
+          choose_play(i);
+        }
+      }
+      apply_plays();
+      for (int i = 0; i < PLAYOUT_LANES; ++i) {
+        if (winner_[i] < 0) {
+          continue;
+        }
+        ++wins[winner_[i]];
+        winner_[i] = -1;
+        if (started < games) {
+          reset(i, state);
+          ++started;
+        } else {
+          finished_[i] = true;
+          --live;
+        }
+      }
+    }
+  }
+
+private:
+  void reset(int i, const State &state) {
+    for (int h = 0; h < MAX_HEIGHT; ++h) {
+      levels_[h][i] = state.levels[h];
+    }
+    for (int player = 0; player < 2; ++player) {
+      pawns_[player][i] = state.pawns[player];
+      for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+        cells_[player][pawn][i] = cell_index(state.position[player][pawn]);
+      }
+    }
+    player_[i] = state.player;
+    finished_[i] = false;
+  }
+
+  // Finds, for every lane, the towers the player to move can step onto and
+  // the cells they mustn't build on because the opponent could then climb
+  // them.
+  void find_threats() {
+    for (int i = 0; i < PLAYOUT_LANES; ++i) {
+      Bitboard one = -player_[i];
+      Bitboard mine = (pawns_[0][i] & ~one) | (pawns_[1][i] & one);
+      Bitboard theirs = (pawns_[1][i] & ~one) | (pawns_[0][i] & one);
+      Bitboard second = levels_[1][i] & ~levels_[2][i];
+      Bitboard third = levels_[2][i] & ~levels_[3][i];
+      wins_[i] = dilate(mine & second) & third;
+      danger_[i] = dilate(theirs & second) & second;
+    }
+  }
+
+  int height(int i, int cell) const {
+    return ((levels_[0][i] >> cell) & 1) + ((levels_[1][i] >> cell) & 1) +
+           ((levels_[2][i] >> cell) & 1) + ((levels_[3][i] >> cell) & 1);
+  }
+
+  // Picks lane i's play the way SimplePlayer::select_move would: a win,
+  // then the only play that blocks a win, then a random play that doesn't
+  // build a tower the opponent can climb. Ends the game instead if there is
+  // a win or no legal play.
+  void choose_play(int i) {
+    const int player = player_[i];
+    if (wins_[i]) {
+      winner_[i] = player;
+      return;
+    }
+    Bitboard open =
+        ~(pawns_[0][i] | pawns_[1][i] | levels_[MAX_HEIGHT - 1][i]) &
+        BOARD_MASK;
+    Bitboard moves[PAWN_COUNT];
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      int start = cells_[player][pawn][i];
+      int h = height(i, start);
+      moves[pawn] = NEIGHBORS[start] & open;
+      if (h + 1 < MAX_HEIGHT) {
+        moves[pawn] &= ~levels_[h + 1][i];
+      }
+    }
+    if (!(moves[0] | moves[1])) {
+      winner_[i] = 1 - player;
+      return;
+    }
+    int first_pawn = moves[0] ? 0 : 1;
+
+    Bitboard third = levels_[2][i] & ~levels_[3][i];
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      int them = cells_[1 - player][pawn][i];
+      Bitboard towers = NEIGHBORS[them] & third;
+      if (height(i, them) != MAX_HEIGHT - 2 || !towers) {
+        continue;
+      }
+      // Only the first tower counts, as in get_obvious_move. Plays that
+      // build on it are the moves to its neighbors.
+      int tower = __builtin_ctz(towers);
+      Bitboard stoppers[PAWN_COUNT] = {moves[0] & NEIGHBORS[tower],
+                                       moves[1] & NEIGHBORS[tower]};
+      int count = __builtin_popcount(stoppers[0]) +
+                  __builtin_popcount(stoppers[1]);
+      if (count == 1) {
+        int stopper = stoppers[0] ? 0 : 1;
+        set_play(i, stopper, __builtin_ctz(stoppers[stopper]), tower);
+        return;
+      } else if (!count) {
+        set_first_play(i, first_pawn, moves[first_pawn]);
+        return;
+      }
+      break;
+    }
+
+    // Count the plays that aren't blunders, then pick one at random.
+    int total = 0;
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      Bitboard ends = moves[pawn];
+      Bitboard start = cell_bit(cells_[player][pawn][i]);
+      while (ends) {
+        int end = pop_cell(&ends);
+        total += __builtin_popcount(
+            (NEIGHBORS[end] & (open | start)) & ~danger_[i]);
+      }
+    }
+    if (!total) {
+      set_first_play(i, first_pawn, moves[first_pawn]);
+      return;
+    }
+    int n = random(i, total);
+    for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+      Bitboard ends = moves[pawn];
+      Bitboard start = cell_bit(cells_[player][pawn][i]);
+      while (ends) {
+        int end = pop_cell(&ends);
+        Bitboard builds = (NEIGHBORS[end] & (open | start)) & ~danger_[i];
+        int count = __builtin_popcount(builds);
+        if (n < count) {
+          set_play(i, pawn, end, nth_cell(builds, n));
+          return;
+        }
+        n -= count;
+      }
+    }
+  }
+
+  // The first play of get_legal_plays, which builds where the pawn started.
+  void set_first_play(int i, int pawn, Bitboard moves) {
+    set_play(i, pawn, __builtin_ctz(moves), cells_[player_[i]][pawn][i]);
+  }
+
+  void set_play(int i, int pawn, int end, int build) {
+    uint8_t &start = cells_[player_[i]][pawn][i];
+    moved_[i] = cell_bit(start) | cell_bit(end);
+    built_[i] = cell_bit(build);
+    start = end;
+  }
+
+  // Moves the pawns, raises the buildings and passes the turn in every lane.
+  // Lanes without a play have empty masks, so nothing changes there but the
+  // player, which reset() sets again.
+  void apply_plays() {
+    for (int i = 0; i < PLAYOUT_LANES; ++i) {
+      Bitboard one = -player_[i];
+      pawns_[0][i] ^= moved_[i] & ~one;
+      pawns_[1][i] ^= moved_[i] & one;
+      Bitboard build = built_[i];
+      levels_[3][i] |= build & levels_[2][i];
+      levels_[2][i] |= build & levels_[1][i];
+      levels_[1][i] |= build & levels_[0][i];
+      levels_[0][i] |= build;
+      player_[i] ^= 1;
+    }
+  }
+
+  // The next number from lane i's splitmix64 generator.
+  uint64_t next_random(int i) {
+    uint64_t z = (rng_[i] += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // A uniform random number below n.
+  int random(int i, int n) {
+    return (static_cast<uint32_t>(next_random(i)) *
+            static_cast<uint64_t>(n)) >> 32;
+  }
+
+  static_assert(MAX_HEIGHT == 4, "apply_plays assumes four levels");
+
+  alignas(32) Bitboard levels_[MAX_HEIGHT][PLAYOUT_LANES];
+  alignas(32) Bitboard pawns_[2][PLAYOUT_LANES];
+  alignas(32) uint32_t player_[PLAYOUT_LANES];
+  alignas(32) Bitboard wins_[PLAYOUT_LANES];   // Towers to step onto.
+  alignas(32) Bitboard danger_[PLAYOUT_LANES]; // Cells not to build on.
+  alignas(32) Bitboard moved_[PLAYOUT_LANES];  // Start and end of the play.
+  alignas(32) Bitboard built_[PLAYOUT_LANES];
+  uint8_t cells_[2][PAWN_COUNT][PLAYOUT_LANES];
+  int winner_[PLAYOUT_LANES]; // Set when a game has just ended.
+  bool finished_[PLAYOUT_LANES];
+  uint64_t rng_[PLAYOUT_LANES];
+};
+
+// PCG32 (XSH RR), a small and fast generator for rollout policies, where
+// mt19937's 2.5 KB of state and a uniform_int_distribution per play cost
+// more than the play itself.
+class Pcg32 {
+public:
+  explicit Pcg32(uint64_t seed) : state_(0) {
+    next();
+    state_ += seed;
+    next();
+  }
+
+  uint32_t next() {
+    uint64_t old = state_;
+    state_ = old * MULTIPLIER + INCREMENT;
+    uint32_t shifted = ((old >> 18) ^ old) >> 27;
+    uint32_t rotation = old >> 59;
+    return (shifted >> rotation) | (shifted << (-rotation & 31));
+  }
+
+  // A number in [0, n), by Lemire's multiply-shift. The bias is far below
+  // anything a rollout could notice.
+  uint32_t below(uint32_t n) { return uint64_t(next()) * n >> 32; }
+
+private:
+  static constexpr uint64_t MULTIPLIER = 6364136223846793005ULL;
+  static constexpr uint64_t INCREMENT = 1442695040888963407ULL;
+  uint64_t state_;
+};
+
+// The cells the player to move can step onto to win right away.
+inline Bitboard get_winning_steps(const State &state) {
+  return dilate(state.pawns[state.player] & state.cells_at(MAX_HEIGHT - 2)) &
+         state.cells_at(MAX_HEIGHT - 1);
+}
+
+// Rollout policies pick plays for playouts. They have the same select_move
+// as the players, so play_game can pit them against each other, and a
+// constructor taking a seed:
+//
+//   explicit Policy(uint64_t seed);
+//   int select_move(const State &state, const Plays &plays);
+//
+// MonteCarlo and SerialPlayouts take one as a template parameter, so the
+// choice costs no virtual calls in the inner loop.
+
+// Always takes the first legal play, which is what MonteCarlo's playouts
+// did before there were policies. Deterministic and as cheap as a policy
+// gets, but the games it plays have little to do with real ones.
+struct FirstPlayPolicy {
+  explicit FirstPlayPolicy(uint64_t) {}
+  int select_move(const State &, const Plays &) { return 0; }
+};
+
+// Picks uniformly among the legal plays.
+class UniformPolicy {
+public:
+  explicit UniformPolicy(uint64_t seed) : rng_(seed) {}
+  int select_move(const State &, const Plays &plays) {
+    return rng_.below(plays.size());
+  }
+
+private:
+  Pcg32 rng_;
+};
+
+// SimplePlayer's policy: win if possible, block a lone threat, and otherwise
+// pick uniformly among the plays that don't build a tower the opponent can
+// climb. The blunder cells come from masks, and the pick is by rejection, so
+// a play usually costs a couple of random numbers rather than a scan.
+class BlunderAvoidingPolicy {
+public:
+  explicit BlunderAvoidingPolicy(uint64_t seed) : rng_(seed) {}
+
+  int select_move(const State &state, const Plays &plays) {
+    if (get_winning_steps(state)) {
+      for (int i = 0; i < plays.size(); ++i) {
+        if (state.get_height(plays[i].end) == MAX_HEIGHT - 1) {
+          return i;
+        }
+      }
+    }
+    Bitboard them = state.pawns[1 - state.player];
+    Bitboard climbers = them & state.cells_at(MAX_HEIGHT - 2);
+    Bitboard climbable = state.cells_at(MAX_HEIGHT - 1);
+    // Like SimplePlayer, only the first threatened tower of the first
+    // threatening pawn counts, though pawns go in cell order here.
+    while (climbers) {
+      Bitboard towers = NEIGHBORS[pop_cell(&climbers)] & climbable;
+      if (towers) {
+        int stopper = block(plays, cell_position(__builtin_ctz(towers)));
+        if (stopper != MORE_THAN_ONE) {
+          return std::max(stopper, 0);
+        }
+        break;
+      }
+    }
+
+    Bitboard danger = dilate(them & state.cells_at(MAX_HEIGHT - 2)) &
+                      state.cells_at(MAX_HEIGHT - 2);
+    if (!danger) {
+      return rng_.below(plays.size());
+    }
+    for (int attempt = 0; attempt < 8; ++attempt) {
+      int i = rng_.below(plays.size());
+      if (!(danger & cell_bit(plays[i].build))) {
+        return i;
+      }
+    }
+    // Mostly blunders, so count the rest and pick one of them.
+    int safe = 0;
+    for (const Play &play : plays) {
+      safe += !(danger & cell_bit(play.build));
+    }
+    if (!safe) {
+      return 0;
+    }
+    int skip = rng_.below(safe);
+    for (int i = 0;; ++i) {
+      if (!(danger & cell_bit(plays[i].build)) && !skip--) {
+        return i;
+      }
+    }
+  }
+
+private:
+  static constexpr int MORE_THAN_ONE = -2;
+
+  // The only play that builds on the tower, -1 if none does or
+  // MORE_THAN_ONE.
+  static int block(const Plays &plays, const Position &tower) {
+    int stopper = -1;
+    for (int i = 0; i < plays.size(); ++i) {
+      if (plays[i].build == tower) {
+        if (stopper >= 0) {
+          return MORE_THAN_ONE;
+        }
+        stopper = i;
+      }
+    }
+    return stopper;
+  }
+
+  Pcg32 rng_;
+};
+
+// Wins if possible, and otherwise draws two plays and keeps the one that
+// ends higher, so pawns tend to climb the way strong players' do.
+class ClimbBiasedPolicy {
+public:
+  explicit ClimbBiasedPolicy(uint64_t seed) : rng_(seed) {}
+
+  int select_move(const State &state, const Plays &plays) {
+    if (get_winning_steps(state)) {
+      for (int i = 0; i < plays.size(); ++i) {
+        if (state.get_height(plays[i].end) == MAX_HEIGHT - 1) {
+          return i;
+        }
+      }
+    }
+    int a = rng_.below(plays.size());
+    int b = rng_.below(plays.size());
+    return state.get_height(plays[b].end) > state.get_height(plays[a].end) ? b
+                                                                           : a;
+  }
+
+private:
+  Pcg32 rng_;
+};
+
+// Plays the game in state out to the end with policy choosing for both
+// sides, and returns the winner.
+template <typename RolloutPolicy>
+int play_out(State *state, RolloutPolicy *policy) {
+  int winner = get_winner(*state);
+  while (winner < 0) {
+    Plays plays = get_legal_plays(*state);
+    Play play = plays[policy->select_move(*state, plays)];
+    make_play(state, play);
+    winner = get_winner_after(*state, play);
+  }
+  return winner;
+}
+
+// Plays games one after another with a rollout policy. It has the same
+// interface as PlayoutBatch, so SimpleRolloutPlayer can take either.
+template <typename RolloutPolicy> class SerialPlayouts {
+public:
+  explicit SerialPlayouts(uint64_t seed) : policy_(seed) {}
+
+  // Plays games from state and adds the number each player won to wins.
+  void run(const State &state, int games, int wins[2]) {
+    for (int game = 0; game < games; ++game) {
+      State board(state);
+      ++wins[play_out(&board, &policy_)];
+    }
+  }
+
+private:
+  RolloutPolicy policy_;
+};
+
+// A fixed-size hash table of search statistics keyed by State::hash.
+//
+// The memory is allocated and touched up front and never grows. Each bucket
+// fills one cache line, so a lookup costs a single cache miss. When a bucket
+// is full, an insert evicts the entry that represents the least search
+// effort: empty entries go first, then entries not looked up since the last
+// call to new_search(), then the one with the lowest priority().
+//
+// Entry must be trivially copyable, all zero when empty, and provide:
+//   uint32_t check;      // Upper half of the key.
+//   uint8_t generation;  // Owned by the table.
+//   uint32_t priority() const;
+template <typename Entry> class TranspositionTable {
+public:
+  explicit TranspositionTable(size_t memory_bytes)
+      : bucket_count_(1), hits_(0), misses_(0), evictions_(0),
+        generation_(1) {
+    while (2 * bucket_count_ * sizeof(Bucket) <= memory_bytes) {
+      bucket_count_ *= 2;
+    }
+    storage_.reset(new char[bucket_count_ * sizeof(Bucket) + CACHE_LINE]);
+    uintptr_t base = reinterpret_cast<uintptr_t>(storage_.get());
+    buckets_ = reinterpret_cast<Bucket *>((base + CACHE_LINE - 1) &
+                                          ~uintptr_t(CACHE_LINE - 1));
+    clear();
+  }
+
+  // Returns the entry for the key, or nullptr if it isn't in the table.
+  Entry *find(uint64_t key) {
+    Bucket &bucket = buckets_[key & (bucket_count_ - 1)];
+    uint32_t check = static_cast<uint32_t>(key >> 32);
+    for (Entry &entry : bucket.entries) {
+      if (entry.check == check && entry.generation) {
+        // Anything looked up is still relevant to the current search.
+        entry.generation = generation_;
+        ++hits_;
+        return &entry;
+      }
+    }
+    ++misses_;
+    return nullptr;
+  }
+
+  // Returns the entry for the key, making a zeroed one if it isn't there.
+  Entry *insert(uint64_t key) {
+    Entry *entry = find(key);
+    if (entry) {
+      return entry;
+    }
+    Bucket &bucket = buckets_[key & (bucket_count_ - 1)];
+    Entry *victim = nullptr;
+    uint64_t victim_score = std::numeric_limits<uint64_t>::max();
+    for (Entry &candidate : bucket.entries) {
+      uint64_t score = 0;
+      if (candidate.generation) {
+        score = 1 + uint64_t(candidate.priority());
+        if (candidate.generation == generation_) {
+          score += uint64_t(1) << 32;
+        }
+      }
+      if (score < victim_score) {
+        victim_score = score;
+        victim = &candidate;
+      }
+    }
+    if (victim->generation) {
+      ++evictions_;
+    } else {
+      ++size_;
+    }
+    memset(static_cast<void *>(victim), 0, sizeof(Entry));
+    victim->check = static_cast<uint32_t>(key >> 32);
+    victim->generation = generation_;
+    return victim;
+  }
+
+  // Marks every entry as stale, so they get replaced first from now on
+  // unless they are looked up again.
+  void new_search() {
+    if (++generation_ == 0) {
+      // Generation 0 means empty, so skip it when wrapping around.
+      generation_ = 1;
+    }
+  }
+
+  void clear() {
+    memset(static_cast<void *>(buckets_), 0, bucket_count_ * sizeof(Bucket));
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return bucket_count_ * ENTRIES_PER_BUCKET; }
+  size_t memory_bytes() const { return bucket_count_ * sizeof(Bucket); }
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+  uint64_t evictions() const { return evictions_; }
+
+private:
+  static constexpr size_t CACHE_LINE = 64;
+  static constexpr size_t ENTRIES_PER_BUCKET = CACHE_LINE / sizeof(Entry);
+  static_assert(ENTRIES_PER_BUCKET >= 2, "Entry is too big for a bucket");
+
+  struct alignas(CACHE_LINE) Bucket {
+    Entry entries[ENTRIES_PER_BUCKET];
+  };
+
+  std::unique_ptr<char[]> storage_;
+  Bucket *buckets_;
+  size_t bucket_count_;
+  size_t size_;
+  uint64_t hits_;
+  uint64_t misses_;
+  uint64_t evictions_;
+  uint8_t generation_;
+};
+
+// A fixed set of threads that run the same task together.
+//
+// The calling thread counts as one of them, so a pool of size 1 starts no
+// threads at all.
+class ThreadPool {
+public:
+  explicit ThreadPool(int thread_count)
+      : task_(nullptr), round_(0), running_(0), stopping_(false) {
+    for (int i = 1; i < thread_count; ++i) {
+      threads_.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    start_.notify_all();
+    for (std::thread &t : threads_) {
+      t.join();
+    }
+  }
+
+  int size() const { return threads_.size() + 1; }
+
+  // Runs task(i) for every i in [0, size()), with task(0) on the calling
+  // thread, and returns once they have all finished.
+  void run(const std::function<void(int)> &task) {
+    if (threads_.empty()) {
+      task(0);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      running_ = threads_.size();
+      ++round_;
+    }
+    start_.notify_all();
+    task(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return running_ == 0; });
+    task_ = nullptr;
+  }
+
+private:
+  void work(int index) {
+    uint64_t round = 0;
+    while (true) {
+      const std::function<void(int)> *task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_.wait(lock, [&]() { return stopping_ || round_ != round; });
+        if (stopping_) {
+          return;
+        }
+        round = round_;
+        task = task_;
+      }
+      (*task)(index);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+      }
+      done_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::function<void(int)> *task_;
+  uint64_t round_;
+  int running_;
+  bool stopping_;
+};
+
+// Hands out tasks to the workers of a ThreadPool.
+//
+// Each worker starts with its own contiguous share of the tasks and takes
+// them from the front. Once its share runs dry, it steals from the back of
+// the other workers' shares, so uneven task lengths don't leave threads
+// idle at the end.
+class WorkStealingQueue {
+public:
+  WorkStealingQueue(const std::vector<int> &tasks, int worker_count) {
+    for (int worker = 0; worker < worker_count; ++worker) {
+      shares_.push_back(std::unique_ptr<Share>(new Share));
+      size_t begin = tasks.size() * worker / worker_count;
+      size_t end = tasks.size() * (worker + 1) / worker_count;
+      shares_.back()->tasks.assign(tasks.begin() + begin,
+                                   tasks.begin() + end);
+    }
+  }
+
+  // Gets the next task for the worker. Returns false when none are left.
+  bool pop(int worker, int *task) {
+    {
+      Share &share = *shares_[worker];
+      std::lock_guard<std::mutex> lock(share.mutex);
+      if (!share.tasks.empty()) {
+        *task = share.tasks.front();
+        share.tasks.pop_front();
+        return true;
+      }
+    }
+    for (size_t i = 1; i < shares_.size(); ++i) {
+      Share &victim = *shares_[(worker + i) % shares_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        *task = victim.tasks.back();
+        victim.tasks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct Share {
+    std::mutex mutex;
+    std::deque<int> tasks;
+  };
+
+  std::vector<std::unique_ptr<Share>> shares_;
+};
+
+// What ProofNumberSearch found.
+struct ProofResult {
+  int winner;        // The player with a forced win, or -1 if not proven.
+  std::vector<Play> line; // Play by play, from the start state to the win.
+  size_t nodes;      // Nodes in the proof tree when the search stopped.
+
+  ProofResult() : winner(-1), nodes(0) {}
+};
+
+// The default memory budget for ProofNumberSearch's tree.
+constexpr size_t DEFAULT_SOLVER_BYTES = size_t(64) << 20;
+
+// How many nodes MonteCarlo lets its solver use by default, which takes
+// about a tenth of a second, and how full the board must be before it
+// tries. Positions with fewer blocks are almost never solved.
+constexpr size_t DEFAULT_SOLVER_NODES = size_t(2) << 20;
+constexpr int DEFAULT_SOLVER_BUILDS = 16;
+
+// Best-first proof-number search.
+//
+// Every node has a proof number, the fewest leaves that would have to be
+// proven to prove the player to move at the root wins, and a disproof
+// number, the same for proving they lose. The search keeps expanding a leaf
+// that is on the way to both, until the root is proven one way or the other
+// or the tree hits its budget.
+//
+// Heights only go up, so the game graph has no cycles and plain tree search
+// is exact.
+class ProofNumberSearch {
+public:
+  explicit ProofNumberSearch(size_t memory_bytes = DEFAULT_SOLVER_BYTES)
+      : capacity_(std::max<size_t>(memory_bytes / sizeof(Node), 1)) {
+    nodes_.reserve(capacity_);
+  }
+
+  // The memory_bytes that fit a tree of the given size.
+  static size_t memory_for(size_t max_nodes) {
+    return max_nodes * sizeof(Node);
+  }
+
+  // Tries to prove a win or a loss for the player to move, with a tree of
+  // at most max_nodes nodes.
+  ProofResult solve(const State &root_state, size_t max_nodes) {
+    max_nodes = std::min(max_nodes, capacity_);
+    attacker_ = root_state.player;
+    nodes_.clear();
+    nodes_.push_back(Node());
+    evaluate(0, root_state, get_winner(root_state));
+    while (nodes_[0].proof && nodes_[0].disproof) {
+      uint32_t node = 0;
+      State state = root_state;
+      while (nodes_[node].child_count) {
+        node = most_proving_child(node, state.player == attacker_);
+        make_play(&state, nodes_[node].play());
+      }
+      if (!expand(node, &state, max_nodes)) {
+        break;
+      }
+      update_ancestors(node, state.player == attacker_);
+    }
+
+    ProofResult result;
+    result.nodes = nodes_.size();
+    if (nodes_[0].proof && nodes_[0].disproof) {
+      return result;
+    }
+    bool win = !nodes_[0].proof;
+    result.winner = win ? attacker_ : 1 - attacker_;
+    // Follow proven children down to a leaf. Any proven child will do for
+    // the loser, since they all lose.
+    uint32_t node = 0;
+    State state = root_state;
+    while (nodes_[node].child_count) {
+      const Node &parent = nodes_[node];
+      for (uint32_t n = parent.first_child;
+           n < parent.first_child + parent.child_count; ++n) {
+        if (!(win ? nodes_[n].proof : nodes_[n].disproof)) {
+          node = n;
+          break;
+        }
+      }
+      result.line.push_back(nodes_[node].play());
+      make_play(&state, nodes_[node].play());
+    }
+    if (get_winner(state) < 0) {
+      // The leaf was proven by a step up to the winning height.
+      for (const Play &play : get_legal_plays(state)) {
+        if (state.get_height(play.end) == MAX_HEIGHT - 1) {
+          result.line.push_back(play);
+          break;
+        }
+      }
+    }
+    return result;
+  }
+
+private:
+  static constexpr uint32_t INFINITE = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+  struct Node {
+    uint32_t proof;
+    uint32_t disproof;
+    uint32_t parent;
+    uint32_t first_child;
+    uint8_t child_count;
+    // The play that leads here from the parent, with cells as indices.
+    uint8_t pawn;
+    uint8_t end;
+    uint8_t build;
+
+    Node()
+        : proof(1), disproof(1), parent(NO_PARENT), first_child(0),
+          child_count(0), pawn(0), end(0), build(0) {}
+
+    Play play() const {
+      Play play;
+      play.pawn = pawn;
+      play.end = cell_position(end);
+      play.build = cell_position(build);
+      return play;
+    }
+  };
+
+  static uint32_t add(uint32_t a, uint32_t b) {
+    return a >= INFINITE - b ? INFINITE : a + b;
+  }
+
+  // Sets the numbers of a new leaf, given the winner of its state if the
+  // game is over. Leaves where the game is over, or where the player to move
+  // can step up to win, are proven straight away.
+  void evaluate(uint32_t node, const State &state, int winner) {
+    if (winner < 0 && has_immediate_win(state)) {
+      winner = state.player;
+    }
+    if (winner >= 0) {
+      nodes_[node].proof = winner == attacker_ ? 0 : INFINITE;
+      nodes_[node].disproof = winner == attacker_ ? INFINITE : 0;
+    }
+  }
+
+  // Gives node a child for each distinct legal play. Returns false if they
+  // don't fit. The state is only changed while the children are evaluated.
+  bool expand(uint32_t node, State *state, size_t max_nodes) {
+    Plays plays = get_distinct_plays(*state, get_legal_plays(*state));
+    if (nodes_.size() + plays.size() > max_nodes) {
+      return false;
+    }
+    uint32_t first = nodes_.size();
+    for (const Play &play : plays) {
+      Node child;
+      child.parent = node;
+      child.pawn = play.pawn;
+      child.end = cell_index(play.end);
+      child.build = cell_index(play.build);
+      nodes_.push_back(child);
+      Undo undo = make_play(state, play);
+      evaluate(nodes_.size() - 1, *state, get_winner_after(*state, play));
+      unmake_play(state, play, undo);
+    }
+    nodes_[node].first_child = first;
+    nodes_[node].child_count = plays.size();
+    return true;
+  }
+
+  // Recomputes the numbers of node and its ancestors from their children,
+  // stopping once they no longer change.
+  void update_ancestors(uint32_t node, bool attacker_to_move) {
+    while (node != NO_PARENT) {
+      Node &parent = nodes_[node];
+      uint32_t min_value = INFINITE;
+      uint32_t sum = 0;
+      for (uint32_t n = parent.first_child;
+           n < parent.first_child + parent.child_count; ++n) {
+        // The attacker needs one proven child, the defender needs them all.
+        uint32_t one = attacker_to_move ? nodes_[n].proof : nodes_[n].disproof;
+        uint32_t all = attacker_to_move ? nodes_[n].disproof : nodes_[n].proof;
+        min_value = std::min(min_value, one);
+        sum = add(sum, all);
+      }
+      uint32_t proof = attacker_to_move ? min_value : sum;
+      uint32_t disproof = attacker_to_move ? sum : min_value;
+      if (proof == parent.proof && disproof == parent.disproof) {
+        return;
+      }
+      parent.proof = proof;
+      parent.disproof = disproof;
+      node = parent.parent;
+      attacker_to_move = !attacker_to_move;
+    }
+  }
+
+  // The child that sets the parent's proof number if the attacker is to
+  // move, or its disproof number if the defender is.
+  uint32_t most_proving_child(uint32_t node, bool attacker_to_move) const {
+    const Node &parent = nodes_[node];
+    for (uint32_t n = parent.first_child;
+         n < parent.first_child + parent.child_count; ++n) {
+      if (attacker_to_move ? nodes_[n].proof == parent.proof
+                           : nodes_[n].disproof == parent.disproof) {
+        return n;
+      }
+    }
+    return parent.first_child;
+  }
+
+  size_t capacity_;
+  std::vector<Node> nodes_;
+  int attacker_; // The player to move at the root.
+};
+
+// The number of blocks and domes on the board.
+inline int count_builds(const State &state) {
+  int count = 0;
+  for (int h = 0; h < MAX_HEIGHT; ++h) {
+    count += __builtin_popcount(state.levels[h]);
+  }
+  return count;
+}
+
+// A node in MonteCarlo's search tree.
+//
+// The children of a node are allocated together, so they sit next to each
+// other in the pool and a node only needs the index of the first one.
+//
+// Several threads can work on the same tree. The counts are atomic, and
+// plays is incremented on the way down, before the result is known. Until
+// the simulation comes back, that looks like a loss to the other threads
+// (a virtual loss), which steers them towards other branches.
+//
+// A node can also be proven: its play wins or loses against any defense.
+// A node with a proven winning child is a proven loss for the player who
+// moved into it, and a node whose children are all proven losses is a
+// proven win.
+struct TreeNode {
+  // A child_count for a node that one thread is busy expanding.
+  static constexpr uint8_t EXPANDING = 0xff;
+  // Set in end when the play moves pawn 1.
+  static constexpr uint8_t PAWN_BIT = 0x80;
+
+  // Values of proof, for the player who made the play.
+  enum Proof : uint8_t { UNPROVEN, PROVEN_WIN, PROVEN_LOSS };
+
+  std::atomic<uint32_t> wins; // For the player who made the play.
+  std::atomic<uint32_t> plays;
+  uint32_t first_child;
+  // Zero until the node is expanded. Written last, with release semantics,
+  // so a thread that sees the count also sees the children.
+  std::atomic<uint8_t> child_count;
+  std::atomic<uint8_t> proof;
+  // The play that leads here from the parent, with cells as indices and the
+  // pawn in PAWN_BIT.
+  uint8_t end;
+  uint8_t build;
+
+  TreeNode()
+      : wins(0), plays(0), first_child(0), child_count(0), proof(UNPROVEN) {}
+
+  // Only for moving nodes around while no search is running.
+  TreeNode(const TreeNode &that)
+      : wins(that.wins.load(std::memory_order_relaxed)),
+        plays(that.plays.load(std::memory_order_relaxed)),
+        first_child(that.first_child),
+        child_count(that.child_count.load(std::memory_order_relaxed)),
+        proof(that.proof.load(std::memory_order_relaxed)), end(that.end),
+        build(that.build) {}
+
+  TreeNode &operator=(const TreeNode &that) {
+    wins.store(that.wins.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+    plays.store(that.plays.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+    first_child = that.first_child;
+    child_count.store(that.child_count.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    proof.store(that.proof.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+    end = that.end;
+    build = that.build;
+    return *this;
+  }
+
+  // The number of children, or zero if the node hasn't been expanded yet.
+  int children() const {
+    uint8_t count = child_count.load(std::memory_order_acquire);
+    return count == EXPANDING ? 0 : count;
+  }
+
+  int end_cell() const { return end & ~PAWN_BIT; }
+
+  Play play() const {
+    Play play;
+    play.pawn = end & PAWN_BIT ? 1 : 0;
+    play.end = cell_position(end_cell());
+    play.build = cell_position(build);
+    return play;
+  }
+
+  void set_play(const Play &play) {
+    end = cell_index(play.end) | (play.pawn ? PAWN_BIT : 0);
+    build = cell_index(play.build);
+  }
+};
+
+static_assert(sizeof(TreeNode) == 16, "TreeNode should stay 16 bytes");
+
+static_assert(MAX_LEGAL_MOVES < TreeNode::EXPANDING,
+              "child_count can't hold every legal play");
+
+// Fixed-capacity storage for TreeNodes.
+//
+// Threads can allocate concurrently. Nodes are never freed one at a time.
+// Instead, keep() copies the subtree below one node into a second buffer
+// and drops everything else at once.
+class NodePool {
+public:
+  explicit NodePool(size_t capacity)
+      : capacity_(capacity), nodes_(new TreeNode[capacity]),
+        spare_(new TreeNode[capacity]), size_(0) {}
+
+  TreeNode &operator[](uint32_t n) { return nodes_[n]; }
+  const TreeNode &operator[](uint32_t n) const { return nodes_[n]; }
+  size_t size() const { return std::min(size_.load(), capacity_); }
+  size_t capacity() const { return capacity_; }
+
+  // Allocates count contiguous zeroed nodes and returns the index of the
+  // first, or returns false if the pool is full.
+  bool allocate(int count, uint32_t *first) {
+    size_t start = size_.fetch_add(count);
+    if (start + count > capacity_) {
+      return false;
+    }
+    for (size_t n = start; n < start + count; ++n) {
+      nodes_[n] = TreeNode();
+    }
+    *first = start;
+    return true;
+  }
+
+  void clear() { size_ = 0; }
+
+  // Makes node the root, at index 0, keeping only its descendants. No search
+  // may be running.
+  void keep(uint32_t node) {
+    spare_[0] = nodes_[node];
+    size_t spare_size = 1;
+    // spare_ doubles as the breadth-first queue of copied nodes whose
+    // children still point into nodes_.
+    for (size_t n = 0; n < spare_size; ++n) {
+      int count = spare_[n].children();
+      if (!count) {
+        // Also drops any expansion that ran out of space.
+        spare_[n].child_count = 0;
+        continue;
+      }
+      uint32_t first = spare_[n].first_child;
+      spare_[n].first_child = spare_size;
+      for (int i = 0; i < count; ++i) {
+        spare_[spare_size++] = nodes_[first + i];
+      }
+    }
+    nodes_.swap(spare_);
+    size_ = spare_size;
+  }
+
+private:
+  size_t capacity_;
+  std::unique_ptr<TreeNode[]> nodes_;
+  std::unique_ptr<TreeNode[]> spare_;
+  std::atomic<size_t> size_;
+};
+
+// How many times its target time a search may take when it is close. These
+// live outside TimeManager because duration's operators take them by
+// reference, which would need out-of-class definitions of static members.
+constexpr int MAX_EXTENSION = 2;
+// The number of moves a game clock plans ahead for.
+constexpr int MOVES_TO_GO = 15;
+
+// Decides how long each search may take, from either a fixed time per move
+// or a clock for the whole game, always by steady_clock.
+//
+// A search gets a target time and a limit. Searches that can tell their
+// choice is settled may stop before the target, and ones whose top plays
+// are still close may run on past it up to the limit.
+class TimeManager {
+public:
+  // Every move gets time_per_move as its target.
+  explicit TimeManager(std::chrono::milliseconds time_per_move)
+      : remaining_(0), increment_(0), game_clock_(false),
+        target_(time_per_move),
+        limit_(time_per_move * MAX_EXTENSION) {}
+
+  // All the moves of a game share total, and each move adds increment.
+  static TimeManager game_clock(
+      std::chrono::milliseconds total,
+      std::chrono::milliseconds increment = std::chrono::milliseconds(0)) {
+    TimeManager time(std::chrono::milliseconds(0));
+    time.remaining_ = total;
+    time.increment_ = increment;
+    time.game_clock_ = true;
+    return time;
+  }
+
+  // Every move stops by limit, with no extension for close choices.
+  static TimeManager hard_limit(std::chrono::milliseconds limit) {
+    TimeManager time(limit);
+    time.limit_ = limit;
+    return time;
+  }
+
+  // Starts timing a move and sets its target and limit.
+  void start() {
+    start_ = std::chrono::steady_clock::now();
+    if (game_clock_) {
+      remaining_ += increment_;
+      // Plan on MOVES_TO_GO more moves, but never spend more than half of
+      // what is left on one.
+      target_ = remaining_ / MOVES_TO_GO;
+      limit_ = std::min(target_ * MAX_EXTENSION, remaining_ / 2);
+    }
+  }
+
+  // Charges the time since start to the game clock.
+  void finish() {
+    if (game_clock_) {
+      remaining_ -= std::min(
+          remaining_,
+          std::chrono::duration_cast<std::chrono::milliseconds>(elapsed()));
+    }
+  }
+
+  std::chrono::steady_clock::duration elapsed() const {
+    return std::chrono::steady_clock::now() - start_;
+  }
+
+  std::chrono::milliseconds target() const { return target_; }
+  std::chrono::milliseconds limit() const { return limit_; }
+  // What is left on the game clock.
+  std::chrono::milliseconds remaining() const { return remaining_; }
+
+private:
+  std::chrono::milliseconds remaining_;
+  std::chrono::milliseconds increment_;
+  bool game_clock_;
+  std::chrono::milliseconds target_;
+  std::chrono::milliseconds limit_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// The parts of a MonteCarlo simulation that telemetry times separately.
+// EXPAND covers adding children, including dropping symmetric plays.
+enum SearchPhase { MOVEGEN, SELECTION, EXPAND, PLAYOUT, BACKPROP, PHASE_COUNT };
+
+const char *const PHASE_NAMES[PHASE_COUNT] = {"movegen", "selection",
+                                              "expand", "playout",
+                                              "backprop"};
+
+// One thread's counters for a search. Building with SANTORINI_TELEMETRY
+// turns them on; otherwise this is empty and everything that updates it
+// compiles to nothing.
+struct SearchTelemetry {
+#ifdef SANTORINI_TELEMETRY
+  uint64_t cycles[PHASE_COUNT];
+  // How many new leaves were added at each depth below the root.
+  uint64_t leaf_depths[MAX_GAME_PLIES + 1];
+
+  void clear() { memset(this, 0, sizeof(*this)); }
+  void add_leaf(int depth) { ++leaf_depths[depth]; }
+#else
+  void clear() {}
+  void add_leaf(int) {}
+#endif
+};
+
+// Charges the time stamp counter's cycles to one SearchPhase at a time,
+// switching with enter(), and to the last one when it goes out of scope.
+class PhaseClock {
+public:
+#ifdef SANTORINI_TELEMETRY
+  PhaseClock(SearchTelemetry *telemetry, SearchPhase phase)
+      : telemetry_(telemetry), phase_(phase), last_(__rdtsc()) {}
+  ~PhaseClock() { enter(phase_); }
+
+  void enter(SearchPhase phase) {
+    uint64_t now = __rdtsc();
+    telemetry_->cycles[phase_] += now - last_;
+    last_ = now;
+    phase_ = phase;
+  }
+
+private:
+  SearchTelemetry *telemetry_;
+  SearchPhase phase_;
+  uint64_t last_;
+#else
+  PhaseClock(SearchTelemetry *, SearchPhase) {}
+  void enter(SearchPhase) {}
+#endif
+};
+
+// A play as JSON, with its cells as [x, y].
+inline std::string play_to_json(const Play &play) {
+  char text[64];
+  snprintf(text, sizeof(text), "\"pawn\":%d,\"end\":[%d,%d],\"build\":[%d,%d]",
+           play.pawn, play.end.x, play.end.y, play.build.x, play.build.y);
+  return text;
+}
+
+// A play as text: the pawn, then the end and build cells as a column
+// letter and a row number. "0b2c3" moves pawn 0 to (1, 1) and builds on
+// (2, 2).
+inline std::string play_to_text(const Play &play) {
+  std::string text = std::to_string(play.pawn);
+  for (const Position &p : {play.end, play.build}) {
+    text += static_cast<char>('a' + p.x);
+    text += static_cast<char>('1' + p.y);
+  }
+  return text;
+}
+
+// Finds the legal play in state that text names. Returns false if there
+// isn't one.
+inline bool play_from_text(const std::string &text, const State &state,
+                           Play *play) {
+  if (get_winner(state) >= 0) {
+    return false;
+  }
+  for (const Play &legal : get_legal_plays(state)) {
+    if (play_to_text(legal) == text) {
+      *play = legal;
+      return true;
+    }
+  }
+  return false;
+}
+
+// What a MonteCarlo search found, besides the play itself.
+struct SearchStats {
+  int64_t games;      // Simulations run.
+  int max_depth;      // Deepest node added to the tree.
+  // Estimated for the player to move, from 0 to 1. A play that wasn't
+  // evaluated, such as the only legal one, gets an even 0.5.
+  double win_percent;
+  bool proven;        // Whether win_percent is exactly 0 or 1.
+  double seconds;     // Time spent searching.
+  size_t reused_nodes; // Tree nodes kept from the previous search.
+  int64_t pondered;    // Simulations run on the opponent's time before it.
+  uint32_t book_visits; // Behind a book move, which runs no simulations.
+
+  SearchStats()
+      : games(0), max_depth(0), win_percent(0.5), proven(false), seconds(0),
+        reused_nodes(0), pondered(0), book_visits(0) {}
+};
+
+// One position in an OpeningBook.
+//
+// The statistics are for the player to move, and the best play is given by
+// its start, end and build cells in the orientation of the key.
+struct BookRecord {
+  PackedState key; // canonical_key of the position.
+  uint32_t wins;
+  uint32_t visits;
+  uint8_t start;
+  uint8_t end;
+  uint8_t build;
+  uint8_t unused[5];
+};
+
+static_assert(sizeof(BookRecord) == 32, "BookRecord must stay 32 bytes");
+
+// The header at the start of an opening book file, followed by the records
+// sorted by key.
+struct BookHeader {
+  char magic[8];
+  uint64_t count;
+};
+
+constexpr char BOOK_MAGIC[8] = {'S', 'N', 'T', 'B', 'O', 'O', 'K', '1'};
+
+// A read-only, memory-mapped book of searched positions, keyed by their
+// canonical_key so that one record covers all 8 orientations.
+class OpeningBook {
+public:
+  OpeningBook() : data_(nullptr), size_(0), records_(nullptr), count_(0) {}
+  OpeningBook(const OpeningBook &) = delete;
+  OpeningBook &operator=(const OpeningBook &) = delete;
+  ~OpeningBook() { close(); }
+
+  // Maps the file into memory. Returns false if it can't be read or isn't a
+  // book.
+  bool open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < static_cast<off_t>(sizeof(BookHeader))) {
+      ::close(fd);
+      return false;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+    data_ = data;
+    size_ = st.st_size;
+    const BookHeader *header = static_cast<const BookHeader *>(data_);
+    if (memcmp(header->magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) ||
+        sizeof(BookHeader) + header->count * sizeof(BookRecord) != size_) {
+      close();
+      return false;
+    }
+    records_ = reinterpret_cast<const BookRecord *>(header + 1);
+    count_ = header->count;
+    return true;
+  }
+
+  void close() {
+    if (data_) {
+      munmap(data_, size_);
+    }
+    data_ = nullptr;
+    records_ = nullptr;
+    size_ = count_ = 0;
+  }
+
+  size_t size() const { return count_; }
+
+  // Returns the record for the state, or nullptr if it isn't in the book.
+  const BookRecord *find(const State &state) const {
+    PackedState key = canonical_key(state);
+    const BookRecord *end = records_ + count_;
+    const BookRecord *record =
+        std::lower_bound(records_, end, key, [](const BookRecord &r,
+                                           const PackedState &k) {
+          return r.key < k;
+        });
+    return record != end && record->key == key ? record : nullptr;
+  }
+
+  // Turns the record's best play back into a play in state, which must
+  // have the record's key.
+  static Play get_play(const State &state, const BookRecord &record) {
+    int t;
+    canonicalize(state, &t);
+    const uint8_t *back = SYMMETRIES.cell[SYMMETRIES.inverse[t]];
+    Position start = cell_position(back[record.start]);
+    Play play;
+    play.pawn = state.position[state.player][0] == start ? 0 : 1;
+    play.end = cell_position(back[record.end]);
+    play.build = cell_position(back[record.build]);
+    return play;
+  }
+
+  // Writes records as a book file, merging records for the same key. The
+  // merged best play is the one from the record with the most visits. Merged
+  // statistics too large for a record are scaled down to fit, keeping their
+  // win percentage.
+  static bool write(const std::string &path, std::vector<BookRecord> records) {
+    std::sort(records.begin(), records.end(),
+         [](const BookRecord &a, const BookRecord &b) {
+           return a.key < b.key || (a.key == b.key && a.visits > b.visits);
+         });
+    const uint64_t max_visits = std::numeric_limits<uint32_t>::max();
+    std::vector<BookRecord> merged;
+    for (size_t i = 0; i < records.size();) {
+      uint64_t wins = 0;
+      uint64_t visits = 0;
+      size_t j = i;
+      for (; j < records.size() && records[j].key == records[i].key; ++j) {
+        wins += records[j].wins;
+        visits += records[j].visits;
+      }
+      if (visits > max_visits) {
+        wins = static_cast<uint64_t>(static_cast<double>(wins) / visits *
+                                     max_visits);
+        visits = max_visits;
+      }
+      merged.push_back(records[i]);
+      merged.back().wins = static_cast<uint32_t>(wins);
+      merged.back().visits = static_cast<uint32_t>(visits);
+      i = j;
+    }
+    BookHeader header;
+    memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.count = merged.size();
+    std::fstream out(path, std::fstream::out | std::fstream::binary |
+                               std::fstream::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(merged.data()),
+              merged.size() * sizeof(BookRecord));
+    return static_cast<bool>(out);
+  }
+
+private:
+  void *data_;
+  size_t size_;
+  const BookRecord *records_;
+  size_t count_;
+};
+
+// The default memory budget for MonteCarlo's tree. Half of it is the spare
+// buffer used when moving the root.
+constexpr size_t DEFAULT_TREE_BYTES = size_t(256) << 20;
+
+// MonteCarlo plays a book move without searching once the book has this many
+// visits for the position.
+constexpr uint32_t DEFAULT_BOOK_VISITS = 100000;
+
+// The most visits that book statistics count for when they seed the tree, so
+// that the search can still overrule them.
+constexpr uint32_t BOOK_PRIOR_PLAYS = 10000;
+
+// How many plays of a child its own statistics need before they count as
+// much as the RAVE statistics for its play, by default. Santorini's plays
+// depend on the heights around them, so RAVE only knows a little and
+// should give way soon.
+constexpr double DEFAULT_RAVE_EQUIVALENCE = 50;
+
+// Playouts leave the tree with RolloutPolicy choosing the plays, one policy
+// per thread. ClimbBiasedPolicy runs at about a third of FirstPlayPolicy's
+// simulation rate, but wins about 80% of games against it at equal time.
+template <bool DO_IMMEDIATE_WIN_CHECK,
+          typename RolloutPolicy = ClimbBiasedPolicy>
+class MonteCarlo : public ProgressLog {
+public:
+  MonteCarlo(std::chrono::milliseconds time_limit, int thread_count = 1,
+             size_t tree_bytes = DEFAULT_TREE_BYTES)
+      : time_(time_limit), pool_(thread_count),
+        nodes_(tree_bytes / (2 * sizeof(TreeNode))), has_root_(false),
+        book_(nullptr), book_visits_(DEFAULT_BOOK_VISITS), solver_nodes_(0),
+        solver_builds_(0), batch_playouts_(false), rollout_seed_(0),
+        telemetry_(pool_.size()), telemetry_out_(nullptr), pondering_(false),
+        can_ponder_(false), ponder_stop_(false), ponder_games_(0),
+        simulation_limit_(0), stop_request_(nullptr), rave_equivalence_(0) {
+    clear_rave();
+  }
+
+  ~MonteCarlo() { stop_pondering(); }
+
+  // Keeps searching in the background after each move, from the position
+  // the opponent has to move in, until the next get_next_play. If the
+  // opponent's move is one the tree has, the next search starts with
+  // everything found while pondering.
+  //
+  // The pondering uses all of the player's threads, so it only comes for
+  // free when there are cores to spare for it.
+  void enable_pondering() { pondering_ = true; }
+
+  // Stops pondering, if the player is, and waits for it to finish.
+  void stop_pondering() {
+    if (ponder_thread_.joinable()) {
+      ponder_stop_.store(true, std::memory_order_relaxed);
+      ponder_thread_.join();
+    }
+  }
+
+  // Looks positions up in book, which must outlive the player. Positions
+  // with at least min_visits are played from the book; others are searched
+  // with their book statistics as a head start.
+  void set_book(const OpeningBook *book,
+                uint32_t min_visits = DEFAULT_BOOK_VISITS) {
+    book_ = book;
+    book_visits_ = min_visits;
+  }
+
+  // Scores new leaves with PLAYOUT_LANES games of SimplePlayer's policy
+  // each, played by a PlayoutBatch per thread, instead of one playout with
+  // RolloutPolicy. Also seeds the rollout policies.
+  void enable_batch_playouts(uint64_t seed = 1) {
+    stop_pondering();
+    batch_playouts_ = true;
+    set_rollout_seed(seed);
+  }
+
+  // Seeds the rollout policies and batches, which otherwise start from 0.
+  void set_rollout_seed(uint64_t seed) {
+    stop_pondering();
+    rollout_seed_ = seed;
+  }
+
+  // Scores children by their own statistics blended with all-moves-as-first
+  // statistics for their play: how the player fared in every simulation
+  // where they made the same move and build, at any ply. The blend starts
+  // out all RAVE and is even once the child has equivalence plays, and
+  // unvisited children are tried in order of their RAVE win percentage.
+  void enable_rave(double equivalence = DEFAULT_RAVE_EQUIVALENCE) {
+    stop_pondering();
+    rave_equivalence_ = equivalence;
+  }
+
+  // Runs a ProofNumberSearch of up to max_nodes nodes before each search
+  // once the board has min_builds blocks. A proven win is played at once.
+  // Only the root is solved, so this helps late in games and not with
+  // opening positions like the sweep's.
+  void enable_solver(size_t max_nodes = DEFAULT_SOLVER_NODES,
+                     int min_builds = DEFAULT_SOLVER_BUILDS) {
+    solver_.reset(
+        new ProofNumberSearch(ProofNumberSearch::memory_for(max_nodes)));
+    solver_nodes_ = max_nodes;
+    solver_builds_ = min_builds;
+  }
+
+  // Replaces the time per move given to the constructor, for instance with
+  // a TimeManager::game_clock at the start of a game.
+  void set_time_manager(const TimeManager &time) { time_ = time; }
+
+  // Ends each search once the root has about limit more plays, rounded up
+  // to STOP_CHECK_INTERVAL simulations, or at its time limit if that comes
+  // first. 0 means no limit.
+  void set_simulation_limit(int64_t limit) { simulation_limit_ = limit; }
+
+  // Ends searches within STOP_CHECK_INTERVAL simulations of another thread
+  // setting *stop, which must outlive the player. nullptr for none.
+  void set_stop_request(const std::atomic<bool> *stop) { stop_request_ = stop; }
+
+  int select_move(const State &state, const Plays &plays) {
+    Play play = get_next_play(state);
+    for (int i = 0; i < plays.size(); ++i) {
+      if (play == plays[i]) {
+        return i;
+      }
+    }
+    *log_ << "No valid move selected. Picking the first.\n";
+    return -1;
+  }
+
+  Play get_next_play(const State &state) {
+    stop_pondering();
+    stats_ = SearchStats();
+    stats_.pondered = ponder_games_;
+    ponder_games_ = 0;
+    can_ponder_ = false;
+    root_json_.clear();
+    for (SearchTelemetry &telemetry : telemetry_) {
+      telemetry.clear();
+    }
+    time_.start();
+    Play play = search(state);
+    stats_.seconds = std::chrono::duration<double>(time_.elapsed()).count();
+    time_.finish();
+    if (telemetry_out_) {
+      write_telemetry(state, play);
+    }
+    if (pondering_ && can_ponder_) {
+      ponder_stop_.store(false, std::memory_order_relaxed);
+      ponder_thread_ = std::thread(&MonteCarlo::ponder, this);
+    }
+    return play;
+  }
+
+  // Writes a JSON record of every move's search to out, one per line, until
+  // called with nullptr. The phase times and leaf depths are only there in
+  // builds with SANTORINI_TELEMETRY.
+  void set_telemetry(std::ostream *out) { telemetry_out_ = out; }
+
+  // Describes the last call to get_next_play.
+  const SearchStats &last_search() const { return stats_; }
+
+private:
+  Play search(const State &state) {
+    Plays legal = get_legal_plays(state);
+
+    if (!legal.size()) {
+      // Having no play loses.
+      stats_.win_percent = 0;
+      stats_.proven = true;
+      Play play;
+      play.pawn = -1; // Negative pawn means error.
+      return play;
+    } else if (legal.size() == 1) {
+      return legal[0];
+    }
+
+    if (DO_IMMEDIATE_WIN_CHECK) {
+      for (Play play : legal) {
+        if (state.get_height(play.end) == MAX_HEIGHT - 1) {
+          stats_.win_percent = 1;
+          stats_.proven = true;
+          return play;
+        }
+      }
+    }
+
+    if (book_) {
+      const BookRecord *record = book_->find(state);
+      if (record && record->visits >= book_visits_) {
+        Play play = OpeningBook::get_play(state, *record);
+        if (std::find(legal.begin(), legal.end(), play) != legal.end()) {
+          *log_ << "book move, visits = " << record->visits << "\n";
+          stats_.book_visits = record->visits;
+          stats_.win_percent =
+              static_cast<double>(record->wins) / record->visits;
+          return play;
+        }
+      }
+    }
+
+    bool lost = false;
+    if (solver_ && count_builds(state) >= solver_builds_) {
+      ProofResult proof = solver_->solve(state, solver_nodes_);
+      if (proof.winner == state.player) {
+        *log_ << "solved win in " << proof.line.size() << " plies\n";
+        stats_.win_percent = 1;
+        stats_.proven = true;
+        return proof.line[0];
+      }
+      // Still search for the play that holds out best in practice.
+      lost = proof.winner >= 0;
+    }
+
+    set_root(state);
+    stats_.reused_nodes = nodes_.size();
+    *log_ << "reused nodes = " << stats_.reused_nodes << "\n";
+    seed_from_book();
+
+    std::atomic<bool> stop(false);
+    run_workers(&stop, true, &stats_.games, &stats_.max_depth);
+
+    *log_ << "Game count = " << stats_.games << "\n";
+
+    const TreeNode &root = nodes_[0];
+    if (!root.children()) {
+      // Not even one simulation finished, so there is nothing to go on.
+      has_root_ = false;
+      stats_.win_percent = lost ? 0 : 0.5;
+      stats_.proven = lost;
+      return legal[0];
+    }
+    double best_win_percent;
+    uint32_t best_child = best_root_child(&best_win_percent);
+    stats_.win_percent = lost ? 0 : best_win_percent;
+    // best_root_child gives a proven child's win percentage as exactly 0 or
+    // 1, even before the proof reaches the root.
+    stats_.proven = lost || root.proof || nodes_[best_child].proof;
+    if (root.proof) {
+      bool win = root.proof == TreeNode::PROVEN_LOSS;
+      *log_ << "proven " << (win ? "win" : "loss") << "\n";
+    }
+    *log_ << "max depth = " << stats_.max_depth << "\n";
+    *log_ << "win percent = " << best_win_percent << "\n";
+    *log_ << "tree size = " << nodes_.size() << " of " << nodes_.capacity()
+         << "\n";
+    Play tree_play = nodes_[best_child].play();
+    Play best_play =
+        transform_play(root_state_, tree_play, root_transform_, state);
+    if (telemetry_out_) {
+      root_json_ = root_children_json(state);
+    }
+    // Keep the whole tree, so that searching this position again carries on
+    // from it, and set_root finds the next position a play and a reply
+    // below. Pondering searches the replies to this play, though, so then
+    // only the play's subtree is kept.
+    if (pondering_) {
+      make_play(&root_state_, tree_play);
+      nodes_.keep(best_child);
+      can_ponder_ = true;
+    }
+    return best_play;
+  }
+
+  // Runs simulations on every worker until *stop is set or the root is
+  // proven, and adds the number run and the deepest leaf to *games and
+  // *max_depth. A timed run sets *stop once should_stop says so; otherwise
+  // it stops by itself only when the tree is full.
+  void run_workers(std::atomic<bool> *stop, bool timed, int64_t *games,
+                   int *max_depth) {
+    std::vector<int> worker_games(pool_.size());
+    std::vector<int> max_depths(pool_.size());
+    const uint64_t start_plays = nodes_[0].plays;
+    const uint64_t rollout_seed = rollout_seed_;
+    rollout_seed_ += uint64_t(pool_.size()) * PLAYOUT_LANES;
+    pool_.run([&](int worker) {
+      uint64_t seed = rollout_seed + uint64_t(worker) * PLAYOUT_LANES;
+      RolloutPolicy policy(seed);
+      // On the worker's stack, since operator new can't align it in C++11.
+      PlayoutBatch batch(seed);
+      PlayoutBatch *leaf_batch = batch_playouts_ ? &batch : nullptr;
+      // A proven root won't change, so stop as soon as it is.
+      while (!stop->load(std::memory_order_relaxed) &&
+             !nodes_[0].proof.load(std::memory_order_relaxed)) {
+        run_simulation(&max_depths[worker], &policy, leaf_batch,
+                       &telemetry_[worker]);
+        worker_games[worker]++;
+        // The first worker keeps time for all of them.
+        if (!worker && !(worker_games[worker] % STOP_CHECK_INTERVAL) &&
+            (timed ? should_stop(start_plays)
+                   : nodes_.size() >= nodes_.capacity())) {
+          stop->store(true, std::memory_order_relaxed);
+        }
+      }
+    });
+    for (int worker = 0; worker < pool_.size(); ++worker) {
+      *games += worker_games[worker];
+      *max_depth = std::max(*max_depth, max_depths[worker]);
+    }
+  }
+
+  // Searches from root_state_, the position after this player's last move,
+  // until stop_pondering.
+  void ponder() {
+    int max_depth = 0;
+    run_workers(&ponder_stop_, false, &ponder_games_, &max_depth);
+  }
+
+  // The root's children as a JSON array, with their plays mapped onto
+  // state, most visited first.
+  std::string root_children_json(const State &state) const {
+    const TreeNode &root = nodes_[0];
+    std::vector<uint32_t> children;
+    for (uint32_t n = root.first_child;
+         n < root.first_child + root.children(); ++n) {
+      children.push_back(n);
+    }
+    std::sort(children.begin(), children.end(), [this](uint32_t a, uint32_t b) {
+      return nodes_[a].plays > nodes_[b].plays;
+    });
+    std::ostringstream json;
+    json << "[";
+    for (size_t i = 0; i < children.size(); ++i) {
+      const TreeNode &child = nodes_[children[i]];
+      Play play =
+          transform_play(root_state_, child.play(), root_transform_, state);
+      json << (i ? "," : "") << "{" << play_to_json(play)
+           << ",\"plays\":" << child.plays << ",\"wins\":" << child.wins
+           << ",\"proof\":" << int(child.proof) << "}";
+    }
+    json << "]";
+    return json.str();
+  }
+
+  // Writes the record for the search that chose play in state.
+  void write_telemetry(const State &state, const Play &play) {
+    std::ostream &out = *telemetry_out_;
+    out << "{\"player\":\"mcts\",\"key\":\""
+        << packed_to_string(canonical_key(state)) << "\",\"play\":{"
+        << play_to_json(play) << "},\"simulations\":" << stats_.games
+        << ",\"seconds\":" << stats_.seconds << ",\"simulations_per_second\":"
+        << (stats_.seconds > 0 ? stats_.games / stats_.seconds : 0)
+        << ",\"max_depth\":" << stats_.max_depth
+        << ",\"win_percent\":" << stats_.win_percent
+        << ",\"proven\":" << (stats_.proven ? "true" : "false")
+        << ",\"reused_nodes\":" << stats_.reused_nodes
+        << ",\"book_visits\":" << stats_.book_visits
+        << ",\"pondered\":" << stats_.pondered
+        << ",\"tree_nodes\":" << nodes_.size()
+        << ",\"tree_capacity\":" << nodes_.capacity()
+        << ",\"root\":" << (root_json_.empty() ? "[]" : root_json_);
+#ifdef SANTORINI_TELEMETRY
+    SearchTelemetry total;
+    total.clear();
+    for (const SearchTelemetry &telemetry : telemetry_) {
+      for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+        total.cycles[phase] += telemetry.cycles[phase];
+      }
+      for (int depth = 0; depth <= MAX_GAME_PLIES; ++depth) {
+        total.leaf_depths[depth] += telemetry.leaf_depths[depth];
+      }
+    }
+    int deepest = MAX_GAME_PLIES;
+    while (deepest > 0 && !total.leaf_depths[deepest]) {
+      --deepest;
+    }
+    out << ",\"leaf_depths\":[";
+    for (int depth = 0; depth <= deepest; ++depth) {
+      out << (depth ? "," : "") << total.leaf_depths[depth];
+    }
+    uint64_t cycles = 0;
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+      cycles += total.cycles[phase];
+    }
+    out << "],\"cycles\":" << cycles << ",\"time_split\":{";
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+      out << (phase ? "," : "") << "\"" << PHASE_NAMES[phase] << "\":"
+          << (cycles ? double(total.cycles[phase]) / cycles : 0);
+    }
+    out << "}";
+#endif
+    out << "}" << std::endl;
+  }
+
+  // The root child to play: the best win percentage, except that a proven
+  // win comes first and a proven loss only if there is nothing else. Sets
+  // *win_percent to its win percentage.
+  uint32_t best_root_child(double *win_percent) const {
+    const TreeNode &root = nodes_[0];
+    uint32_t best_child = root.first_child;
+    double best_win_percent = -1;
+    double best_rank = -3;
+    for (uint32_t n = root.first_child;
+         n < root.first_child + root.children(); ++n) {
+      const TreeNode &child = nodes_[n];
+      uint64_t plays = child.plays.load(std::memory_order_relaxed);
+      double win_percent =
+          plays ? static_cast<double>(child.wins) / plays : 0.0;
+      double rank = win_percent;
+      uint8_t proof = child.proof.load(std::memory_order_relaxed);
+      if (proof == TreeNode::PROVEN_WIN) {
+        win_percent = 1;
+        rank = 2;
+      } else if (proof == TreeNode::PROVEN_LOSS) {
+        win_percent = 0;
+        rank -= 2;
+      }
+      if (rank > best_rank) {
+        best_rank = rank;
+        best_win_percent = win_percent;
+        best_child = n;
+      }
+    }
+    *win_percent = best_win_percent;
+    return best_child;
+  }
+
+  // Decides whether the search should stop, given the root's plays when it
+  // started. It always stops at the time limit. Before the target it stops
+  // once the most visited child is also the best and is too far ahead on
+  // visits to be caught at the current rate. Past the target it goes on
+  // only while the top two children are close.
+  bool should_stop(uint64_t start_plays) const {
+    if (time_.elapsed() >= time_.limit() ||
+        (stop_request_ && stop_request_->load(std::memory_order_relaxed))) {
+      return true;
+    }
+    if (simulation_limit_ &&
+        nodes_[0].plays.load(std::memory_order_relaxed) - start_plays >=
+            uint64_t(simulation_limit_)) {
+      return true;
+    }
+    double elapsed = std::chrono::duration<double>(time_.elapsed()).count();
+    double target = std::chrono::duration<double>(time_.target()).count();
+    const TreeNode &root = nodes_[0];
+    if (root.children() < 2) {
+      return elapsed >= target;
+    }
+    uint64_t most = 0;
+    uint64_t second = 0;
+    uint32_t most_child = 0;
+    for (uint32_t n = root.first_child;
+         n < root.first_child + root.children(); ++n) {
+      uint64_t plays = nodes_[n].plays.load(std::memory_order_relaxed);
+      if (plays > most) {
+        second = most;
+        most = plays;
+        most_child = n;
+      } else if (plays > second) {
+        second = plays;
+      }
+    }
+    double win_percent;
+    bool settled = most_child == best_root_child(&win_percent);
+    if (elapsed >= target) {
+      return settled && second < CLOSE_VISITS * most;
+    }
+    double rate = (root.plays.load(std::memory_order_relaxed) - start_plays) /
+                  std::max(elapsed, 1e-6);
+    return settled && most - second > rate * (target - elapsed);
+  }
+
+  // Makes state the root of the tree, keeping the subtree for it if the
+  // previous root is at most two plies above it.
+  //
+  // The tree may hold a symmetric copy of state, since each node only keeps
+  // one of a set of symmetric children. Then root_state_ is that copy and
+  // root_transform_ maps it onto state.
+  void set_root(const State &state) {
+    if (has_root_ && find_symmetry(root_state_, state) < 0) {
+      State found;
+      uint32_t node = find_descendant(0, root_state_, state, 2, &found);
+      if (node) {
+        nodes_.keep(node);
+        root_state_ = found;
+        age_rave();
+      } else {
+        has_root_ = false;
+      }
+    }
+    if (!has_root_) {
+      nodes_.clear();
+      clear_rave();
+      uint32_t root;
+      nodes_.allocate(1, &root);
+      root_state_ = state;
+      has_root_ = true;
+    }
+    root_transform_ = find_symmetry(root_state_, state);
+  }
+
+  // Expands a fresh root and gives its children the statistics the book has
+  // for them, either from their own records or from the root's best play.
+  void seed_from_book() {
+    if (!book_ || nodes_[0].children()) {
+      return;
+    }
+    const BookRecord *record = book_->find(root_state_);
+    PackedState best_key;
+    if (record) {
+      best_key = canonical_key(get_next_state(
+          root_state_, OpeningBook::get_play(root_state_, *record)));
+    }
+    if (!expand(0, root_state_, get_legal_plays(root_state_))) {
+      return;
+    }
+    TreeNode &root = nodes_[0];
+    uint32_t total = 0;
+    for (uint32_t n = root.first_child;
+         n < root.first_child + root.children(); ++n) {
+      State next_state = get_next_state(root_state_, nodes_[n].play());
+      uint64_t wins = 0;
+      uint64_t plays = 0;
+      const BookRecord *reply = book_->find(next_state);
+      if (reply) {
+        // The reply's statistics are for the other player.
+        wins = reply->visits - reply->wins;
+        plays = reply->visits;
+      } else if (record && canonical_key(next_state) == best_key) {
+        wins = record->wins;
+        plays = record->visits;
+      }
+      if (plays > BOOK_PRIOR_PLAYS) {
+        wins = wins * BOOK_PRIOR_PLAYS / plays;
+        plays = BOOK_PRIOR_PLAYS;
+      }
+      nodes_[n].wins.store(wins, std::memory_order_relaxed);
+      nodes_[n].plays.store(plays, std::memory_order_relaxed);
+      total += plays;
+    }
+    root.plays.fetch_add(total, std::memory_order_relaxed);
+  }
+
+  // Returns the index of the node for target, or a symmetric copy of it, at
+  // most depth plies below node and sets *found to its state. Returns 0 if
+  // there isn't one.
+  uint32_t find_descendant(uint32_t node, const State &state,
+                           const State &target, int depth, State *found) {
+    const TreeNode &parent = nodes_[node];
+    for (uint32_t n = parent.first_child;
+         n < parent.first_child + parent.children(); ++n) {
+      State next_state = get_next_state(state, nodes_[n].play());
+      if (find_symmetry(next_state, target) >= 0) {
+        *found = next_state;
+        return n;
+      }
+      if (depth > 1) {
+        uint32_t descendant =
+            find_descendant(n, next_state, target, depth - 1, found);
+        if (descendant) {
+          return descendant;
+        }
+      }
+    }
+    return 0;
+  }
+
+  // Gives node one child for each legal play, leaving out plays that are
+  // symmetric to another child so they share its statistics. Returns false
+  // if another thread got there first or the pool is full.
+  //
+  // Nodes without legal plays are terminal and never get expanded, so no
+  // separate flag is needed.
+  bool expand(uint32_t node, const State &state, const Plays &all_legal) {
+    TreeNode &parent = nodes_[node];
+    uint8_t unexpanded = 0;
+    if (!parent.child_count.compare_exchange_strong(unexpanded,
+                                                    TreeNode::EXPANDING)) {
+      return false;
+    }
+    Plays legal = get_distinct_plays(state, all_legal);
+    uint32_t first;
+    if (!nodes_.allocate(legal.size(), &first)) {
+      // Leave it marked so nobody else tries; keep() clears the mark.
+      return false;
+    }
+    for (int i = 0; i < legal.size(); ++i) {
+      nodes_[first + i].set_play(legal[i]);
+    }
+    parent.first_child = first;
+    parent.child_count.store(legal.size(), std::memory_order_release);
+    return true;
+  }
+
+  // Runs one simulation. With a batch, the new leaf is scored by a batch of
+  // games with SimplePlayer's policy instead of a single playout.
+  void run_simulation(int *max_depth, RolloutPolicy *policy,
+                      PlayoutBatch *batch, SearchTelemetry *telemetry) {
+    PhaseClock clock(telemetry, SELECTION);
+#ifdef SANTORINI_COUNT_ALLOCATIONS
+    const uint64_t allocations = thread_allocations();
+#endif
+    // The nodes below the root on this simulation's path.
+    Path path;
+
+    int winner = -1;
+    // Games won by each player, out of games, for batched playouts.
+    int wins[2] = {0, 0};
+    int games = 1;
+    uint32_t node = 0;
+    bool in_tree = true;
+    // Whether node is the node for this_state, which stops being true once
+    // the playout leaves the tree.
+    bool at_node = true;
+    // The length of the path from the root, before any immediate wins
+    // credited at its end.
+    size_t chain = std::numeric_limits<size_t>::max();
+    // The RAVE entries of the plays made, each only the first time.
+    SmallVec<uint16_t, MAX_GAME_PLIES> rave_plays;
+    uint64_t rave_seen[(RAVE_ENTRIES + 63) / 64] = {};
+    State this_state = root_state_;
+    nodes_[0].plays++;
+    for (int t = 0;; ++t) {
+      clock.enter(MOVEGEN);
+      Plays legal = get_legal_plays(this_state);
+      clock.enter(in_tree ? SELECTION : PLAYOUT);
+
+      if (DO_IMMEDIATE_WIN_CHECK && has_immediate_win(this_state)) {
+        winner = this_state.player;
+        if (at_node) {
+          chain = path.size();
+          TreeNode &parent = nodes_[node];
+          parent.proof.store(TreeNode::PROVEN_LOSS, std::memory_order_relaxed);
+          // Count all the plays ending on MAX_HEIGHT - 1 as won.
+          for (uint32_t n = parent.first_child;
+               n < parent.first_child + parent.children(); ++n) {
+            if (this_state.get_height(nodes_[n].end_cell()) ==
+                MAX_HEIGHT - 1) {
+              nodes_[n].plays++;
+              nodes_[n].proof.store(TreeNode::PROVEN_WIN,
+                                    std::memory_order_relaxed);
+              path.push_back(Visit(n, winner));
+            }
+          }
+        }
+        break;
+      }
+
+      if (!in_tree && batch) {
+        batch->run(this_state, PLAYOUT_LANES, wins);
+        games = PLAYOUT_LANES;
+        break;
+      }
+
+      Play play;
+      bool from_tree = false;
+      if (in_tree) {
+        bool expanded = nodes_[node].children();
+        if (!expanded) {
+          clock.enter(EXPAND);
+          expanded = expand(node, this_state, legal);
+          clock.enter(SELECTION);
+        }
+        if (!expanded) {
+          // Out of space, or another thread is expanding this node, so
+          // just play out the game from here.
+          in_tree = false;
+        } else {
+          node = select_child(node, this_state.player);
+          play = nodes_[node].play();
+          from_tree = true;
+          path.push_back(Visit(node, this_state.player));
+          if (!nodes_[node].plays++) {
+            // First visit to this node, so play out the game from here.
+            in_tree = false;
+            telemetry->add_leaf(t);
+            if (t > *max_depth) {
+              *max_depth = t;
+            }
+          }
+          uint8_t proof = nodes_[node].proof.load(std::memory_order_relaxed);
+          if (proof) {
+            // The result is already known, so there is nothing to play out.
+            winner = proof == TreeNode::PROVEN_WIN ? this_state.player
+                                                   : 1 - this_state.player;
+            break;
+          }
+        }
+      }
+      at_node = from_tree;
+      if (!from_tree) {
+        clock.enter(PLAYOUT);
+        play = legal[policy->select_move(this_state, legal)];
+      }
+
+      if (rave_equivalence_ > 0) {
+        int entry = rave_entry(this_state.player, cell_index(play.end),
+                               cell_index(play.build));
+        uint64_t bit = uint64_t(1) << (entry % 64);
+        if (!(rave_seen[entry / 64] & bit)) {
+          rave_seen[entry / 64] |= bit;
+          rave_plays.push_back(entry);
+        }
+      }
+      make_play(&this_state, play);
+
+      winner = get_winner_after(this_state, play);
+      if (winner >= 0) {
+        if (at_node && node) {
+          nodes_[node].proof.store(winner == this_state.player
+                                       ? TreeNode::PROVEN_LOSS
+                                       : TreeNode::PROVEN_WIN,
+                                   std::memory_order_relaxed);
+        }
+        break;
+      }
+    }
+
+    clock.enter(BACKPROP);
+    backup_proof(path, std::min(chain, static_cast<size_t>(path.size())));
+
+    if (winner >= 0) {
+      wins[winner] = 1;
+    }
+    // One play each was counted on the way down.
+    if (games > 1) {
+      nodes_[0].plays += games - 1;
+    }
+    for (const Visit &visit : path) {
+      TreeNode &visited = nodes_[visit.node];
+      if (games > 1) {
+        visited.plays += games - 1;
+      }
+      if (wins[visit.mover]) {
+        visited.wins += wins[visit.mover];
+      }
+    }
+    for (uint16_t entry : rave_plays) {
+      RaveStats &stats = rave_[entry];
+      stats.plays.fetch_add(games, std::memory_order_relaxed);
+      int mover = entry / (CELL_COUNT * CELL_COUNT);
+      if (wins[mover]) {
+        stats.wins.fetch_add(wins[mover], std::memory_order_relaxed);
+      }
+    }
+#ifdef SANTORINI_COUNT_ALLOCATIONS
+    assert(thread_allocations() == allocations &&
+           "run_simulation must not allocate");
+#endif
+  }
+
+  // What backpropagation needs to know about a node on the path.
+  struct Visit {
+    uint32_t node;
+    int mover; // The player who made the play into the node.
+
+    Visit() {}
+    Visit(uint32_t node, int mover) : node(node), mover(mover) {}
+  };
+
+  // A simulation's path: at most one node per ply, then the winning plays
+  // credited at the end.
+  using Path = SmallVec<Visit, MAX_GAME_PLIES + MAX_LEGAL_MOVES>;
+
+  // Passes proofs up the first chain nodes of the path, from the end,
+  // until a parent can't be proven.
+  void backup_proof(const Path &path, size_t chain) {
+    for (size_t i = chain; i-- > 0;) {
+      uint8_t proof =
+          nodes_[path[i].node].proof.load(std::memory_order_relaxed);
+      TreeNode &parent = nodes_[i ? path[i - 1].node : 0];
+      if (proof == TreeNode::PROVEN_WIN) {
+        parent.proof.store(TreeNode::PROVEN_LOSS, std::memory_order_relaxed);
+      } else if (proof == TreeNode::PROVEN_LOSS && all_children_lose(parent)) {
+        parent.proof.store(TreeNode::PROVEN_WIN, std::memory_order_relaxed);
+      } else {
+        return;
+      }
+    }
+  }
+
+  bool all_children_lose(const TreeNode &parent) const {
+    int count = parent.children();
+    for (uint32_t n = parent.first_child; n < parent.first_child + count;
+         ++n) {
+      if (nodes_[n].proof.load(std::memory_order_relaxed) !=
+          TreeNode::PROVEN_LOSS) {
+        return false;
+      }
+    }
+    return count > 0;
+  }
+
+  // Picks a proven win if it comes across one, then the first unvisited
+  // child, otherwise the child with the best upper confidence bound. Proven
+  // losses are only picked when there is nothing else. With RAVE, the
+  // bound is on the blended win percentage and the unvisited child is the
+  // one with the best RAVE win percentage. player is the one to move.
+  uint32_t select_child(uint32_t node, int player) {
+    const TreeNode &parent = nodes_[node];
+    double log_total = std::log(parent.plays.load(std::memory_order_relaxed));
+    uint32_t first = parent.first_child;
+    uint32_t best = first;
+    double best_score = -1;
+    uint32_t unvisited = 0;
+    double best_rave = -1;
+    for (uint32_t n = first; n < first + parent.children(); ++n) {
+      const TreeNode &child = nodes_[n];
+      uint8_t proof = child.proof.load(std::memory_order_relaxed);
+      if (proof == TreeNode::PROVEN_WIN) {
+        return n;
+      } else if (proof == TreeNode::PROVEN_LOSS) {
+        continue;
+      }
+      uint32_t plays = child.plays.load(std::memory_order_relaxed);
+      double rave =
+          rave_equivalence_ > 0 ? rave_win_percent(player, child) : -1;
+      if (!plays) {
+        if (rave < 0) {
+          return n;
+        } else if (rave > best_rave) {
+          best_rave = rave;
+          unvisited = n;
+        }
+        continue;
+      }
+      double win_percent = static_cast<double>(child.wins) / plays;
+      if (rave >= 0) {
+        // The schedule from Gelly and Silver's MC-RAVE, which gives RAVE
+        // half the weight at rave_equivalence_ plays.
+        double beta =
+            std::sqrt(rave_equivalence_ / (3 * plays + rave_equivalence_));
+        win_percent += beta * (rave - win_percent);
+      }
+      double score = win_percent + std::sqrt(2 * log_total / plays);
+      if (score > best_score) {
+        best_score = score;
+        best = n;
+      }
+    }
+    return best_rave >= 0 ? unvisited : best;
+  }
+
+  // The RAVE win percentage of player making child's play, or an even
+  // chance before any simulation has made it.
+  double rave_win_percent(int player, const TreeNode &child) const {
+    const RaveStats &stats =
+        rave_[rave_entry(player, child.end_cell(), child.build)];
+    uint32_t plays = stats.plays.load(std::memory_order_relaxed);
+    return plays ? static_cast<double>(
+                       stats.wins.load(std::memory_order_relaxed)) /
+                       plays
+                 : 0.5;
+  }
+
+  // The index into rave_ of player moving to the end cell and building on
+  // the build cell.
+  static int rave_entry(int player, int end, int build) {
+    return (player * CELL_COUNT + end) * CELL_COUNT + build;
+  }
+
+  void clear_rave() {
+    for (RaveStats &stats : rave_) {
+      stats.wins.store(0, std::memory_order_relaxed);
+      stats.plays.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Halves the RAVE statistics when the root moves down the tree, so that
+  // the simulations from the new root soon outweigh the old ones.
+  void age_rave() {
+    for (RaveStats &stats : rave_) {
+      stats.wins.store(stats.wins.load(std::memory_order_relaxed) / 2,
+                       std::memory_order_relaxed);
+      stats.plays.store(stats.plays.load(std::memory_order_relaxed) / 2,
+                        std::memory_order_relaxed);
+    }
+  }
+
+  // How many simulations the first worker runs between checks of the time.
+  static constexpr int STOP_CHECK_INTERVAL = 256;
+  // One RAVE entry for each player, end cell and build cell.
+  static constexpr int RAVE_ENTRIES = 2 * CELL_COUNT * CELL_COUNT;
+
+  // The all-moves-as-first statistics of a play, for the player making it.
+  struct RaveStats {
+    std::atomic<uint32_t> wins;
+    std::atomic<uint32_t> plays;
+  };
+  // Past the target, a runner-up with this share of the most visited
+  // child's visits keeps the search going.
+  static constexpr double CLOSE_VISITS = 0.7;
+
+  TimeManager time_;
+  SearchStats stats_;
+  ThreadPool pool_;
+  NodePool nodes_;
+  bool has_root_;
+  State root_state_;
+  int root_transform_; // Takes root_state_ to the state being played.
+  const OpeningBook *book_;
+  uint32_t book_visits_; // Book visits needed to skip the search.
+  std::unique_ptr<ProofNumberSearch> solver_;
+  size_t solver_nodes_;
+  int solver_builds_;
+  bool batch_playouts_;
+  uint64_t rollout_seed_; // Advanced every search, so none reuse a seed.
+  std::vector<SearchTelemetry> telemetry_; // One per worker.
+  std::ostream *telemetry_out_;
+  std::string root_json_; // The last search's root children, for telemetry.
+  bool pondering_;
+  bool can_ponder_; // Whether the last move left root_state_ to ponder on.
+  std::atomic<bool> ponder_stop_;
+  int64_t ponder_games_; // Simulations run while pondering.
+  std::thread ponder_thread_;
+  int64_t simulation_limit_; // 0 for none.
+  const std::atomic<bool> *stop_request_;
+  double rave_equivalence_; // 0 when RAVE is off.
+  RaveStats rave_[RAVE_ENTRIES];
+};
+
+// Plays the game with the state as the starting state and the scratch space.
+//
+// Returns the index of the winning player (either 0 or 1).
+template <bool verbose = false, typename P0, typename P1>
+int play_game(State *state, P0 *p0, P1 *p1) {
+  for (int move_number = 0;; ++move_number) {
+    if (verbose) {
+      printf("Move %2d\n", move_number);
+    }
+    Plays plays = get_legal_plays(*state);
+    if (!plays.size()) {
+      // Next player loses because they have no legal moves.
+      if (verbose) {
+        printf("Player %d wins because player %d has no legal moves.\n",
+               1 - state->player, state->player);
+      }
+      return 1 - state->player;
+    }
+    int index = state->player ? p1->select_move(*state, plays)
+                              : p0->select_move(*state, plays);
+    Play play = plays[index];
+    if (state->get_height(play.end) == MAX_HEIGHT - 1) {
+      // Next player wins because they stepped to the winning height.
+      int winner = state->player;
+      if (verbose) {
+        printf("Player %d wins by stepping onto (%d,%d)\n", state->player,
+               play.end.x, play.end.y);
+        make_play(state, play);
+        print_state(*state);
+      }
+      return winner;
+    }
+    if (verbose) {
+      printf("Player %d moves pawn %d to (%d,%d) and builds at (%d,%d)\n",
+             state->player, play.pawn, play.end.x, play.end.y, play.build.x,
+             play.build.y);
+    }
+    // Update board due to selected move.
+    make_play(state, play);
+    if (verbose) {
+      print_state(*state);
+    }
+  }
+}
+
+// Scores each play by the games that Playouts plays from it: PlayoutBatch
+// for SimplePlayer's policy, or SerialPlayouts for any rollout policy.
+template <typename Playouts = PlayoutBatch>
+class SimpleRolloutPlayer : public SimplePlayer {
+public:
+  // With more than one thread, the rollouts are spread across a thread pool,
+  // each thread with its own Playouts seeded from this player's RNG.
+  SimpleRolloutPlayer(std::chrono::milliseconds time_limit, unsigned int seed,
+                      int thread_count = 1)
+      : SimplePlayer(seed), time_limit_(time_limit), pool_(thread_count) {}
+
+  int select_move(const State &state, const Plays &plays) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    int obvious = get_obvious_move(state, plays);
+    if (obvious >= 0) {
+      return obvious;
+    }
+
+    auto blunders = get_blunders(state, plays);
+    if (blunders.size() == plays.size()) {
+      // All the moves are losers, so just pick the first one,
+      // you loser.
+      return 0;
+    }
+
+    // Collect moves that aren't blunders.
+    SmallVec<Node, MAX_LEGAL_MOVES> nodes;
+    int blunder_index = 0;
+    for (int i = 0; i < plays.size(); ++i) {
+      if (blunders.size() && i == blunders[blunder_index]) {
+        ++blunder_index;
+        continue;
+      }
+      Node node;
+      node.index = i;
+      node.wins = 0;
+      node.visits = 0;
+      nodes.push_back(node);
+    }
+
+    // Each worker keeps its own counts, which get added up afterwards in
+    // worker order.
+    std::uniform_int_distribution<unsigned int> seed_dist;
+    std::vector<unsigned int> seeds;
+    std::vector<std::vector<Node>> worker_nodes;
+    for (int worker = 0; worker < pool_.size(); ++worker) {
+      seeds.push_back(seed_dist(rng_));
+      worker_nodes.push_back(std::vector<Node>(nodes.begin(), nodes.end()));
+    }
+    pool_.run([&](int worker) {
+      Playouts playouts(seeds[worker]);
+      std::vector<Node> &counts = worker_nodes[worker];
+      // Worker w takes every size()-th node starting from w, so between
+      // them the workers cover every node evenly.
+      int step = pool_.size();
+      for (int n = worker % counts.size();; n = (n + step) % counts.size()) {
+        // Keep going until time expires.
+        if (std::chrono::steady_clock::now() - start_time > time_limit_) {
+          break;
+        }
+        Play play = plays[counts[n].index];
+        int wins[2] = {0, 0};
+        playouts.run(get_next_state(state, play), ROLLOUTS_PER_VISIT,
+                     wins);
+        counts[n].wins += wins[state.player];
+        counts[n].visits += ROLLOUTS_PER_VISIT;
+      }
+    });
+    double rollout_count = 0;
+    for (const std::vector<Node> &counts : worker_nodes) {
+      for (int n = 0; n < nodes.size(); ++n) {
+        nodes[n].wins += counts[n].wins;
+        nodes[n].visits += counts[n].visits;
+        rollout_count += counts[n].visits;
+      }
+    }
+    *log_ << "Rollout count = " << rollout_count << "\n";
+
+    int best_index = -1;
+    double best_ratio = std::numeric_limits<double>::lowest();
+    for (const auto &node : nodes) {
+      double ratio = static_cast<double>(node.wins) / node.visits;
+      if (ratio > best_ratio) {
+        best_ratio = ratio;
+        best_index = node.index;
+      }
+    }
+    *log_ << "Best ratio = " << best_ratio << "\n";
+    return best_index;
+  }
+
+private:
+  // Rollouts per play each time a worker comes round to it.
+  static constexpr int ROLLOUTS_PER_VISIT = 100;
+
+  struct Node {
+    int index;
+    int wins;
+    int visits;
+  };
+
+  std::chrono::milliseconds time_limit_;
+  ThreadPool pool_;
+};
+
+// Scores for NegamaxPlayer are from the point of view of the player to move.
+// A win in n plies scores WIN_SCORE - n, so quicker wins score higher.
+constexpr int WIN_SCORE = 1000000;
+constexpr int INFINITE_SCORE = WIN_SCORE + 1;
+
+// The deepest NegamaxPlayer's iterative deepening goes.
+constexpr int MAX_SEARCH_PLY = 64;
+
+// The history scores of NegamaxPlayer's plays are halved whenever one
+// passes this, which keeps them well within an int and below the climb
+// part of the ordering keys.
+constexpr int MAX_HISTORY = 1 << 20;
+
+// The default memory budget for NegamaxPlayer's transposition table.
+constexpr size_t DEFAULT_NEGAMAX_TABLE_BYTES = size_t(64) << 20;
+
+// Evaluation weights for a pawn by its height, then for each neighbor it can
+// move to, each neighbor one level up and a neighbor it can win on.
+constexpr int PAWN_HEIGHT_SCORE[MAX_HEIGHT] = {0, 30, 90, 300};
+constexpr int MOBILITY_SCORE = 4;
+constexpr int CLIMB_SCORE = 10;
+constexpr int THREAT_SCORE = 60;
+// Evaluation weight for each step a pawn is from the edge of the board.
+constexpr int CENTER_SCORE = 5;
+
+// What NegamaxPlayer's table knows about a state.
+struct NegamaxEntry {
+  enum Bound : uint8_t { EXACT, LOWER, UPPER };
+
+  uint32_t check;
+  int32_t score;
+  uint8_t generation;
+  int8_t depth;
+  uint8_t bound;
+  // The best play found, with cells as indices. end == build means none,
+  // since a pawn never builds where it stands.
+  uint8_t pawn;
+  uint8_t end;
+  uint8_t build;
+
+  uint32_t priority() const { return depth; }
+};
+
+// Iterative-deepening negamax with alpha-beta pruning.
+//
+// Plays are tried in the order: the table's best play, the two killer plays
+// that last caused a cutoff at the same ply, then plays that climb the most,
+// breaking ties by history scores of plays that caused cutoffs before.
+class NegamaxPlayer : public ProgressLog {
+public:
+  explicit NegamaxPlayer(std::chrono::milliseconds time_limit,
+                         size_t table_bytes = DEFAULT_NEGAMAX_TABLE_BYTES)
+      : time_(time_limit), table_(table_bytes), telemetry_out_(nullptr) {
+    memset(history_, 0, sizeof(history_));
+  }
+
+  // Replaces the time per move given to the constructor, for instance with
+  // a TimeManager::game_clock at the start of a game.
+  void set_time_manager(const TimeManager &time) { time_ = time; }
+
+  // Writes a JSON record of every move's search to out, one per line, until
+  // called with nullptr.
+  void set_telemetry(std::ostream *out) { telemetry_out_ = out; }
+
+  int select_move(const State &state, const Plays &plays) {
+    for (int i = 0; i < plays.size(); ++i) {
+      if (state.get_height(plays[i].end) == MAX_HEIGHT - 1) {
+        return i;
+      }
+    }
+
+    table_.new_search();
+    age_history();
+    for (int ply = 0; ply < MAX_SEARCH_PLY; ++ply) {
+      killers_[ply][0].pawn = killers_[ply][1].pawn = -1;
+    }
+    nodes_ = 0;
+    stopped_ = false;
+    const uint64_t hits = table_.hits();
+    const uint64_t lookups = hits + table_.misses();
+    time_.start();
+    deadline_ = std::chrono::steady_clock::now() + time_.limit();
+
+    int best = 0;
+    int best_score = 0;
+    int depth = 0;
+    bool changed = false;
+    while (depth < MAX_SEARCH_PLY) {
+      // The next depth takes longer than all the ones before, so don't start
+      // it past half the target unless the best play just changed, and then
+      // not past the target.
+      if (depth && time_.elapsed() >= (changed ? time_.target()
+                                               : time_.target() / 2)) {
+        break;
+      }
+      int score;
+      int index = search_root(state, plays, depth + 1, &score);
+      if (stopped_) {
+        break;
+      }
+      changed = depth && index != best;
+      best = index;
+      best_score = score;
+      ++depth;
+      if (std::abs(score) >= WIN_SCORE - MAX_SEARCH_PLY) {
+        // The result is proven, so deeper searches can't change it.
+        break;
+      }
+    }
+    double seconds = std::chrono::duration<double>(time_.elapsed()).count();
+    time_.finish();
+    *log_ << "depth = " << depth << ", score = " << best_score
+          << ", nodes = " << nodes_ << "\n";
+    if (telemetry_out_) {
+      uint64_t search_hits = table_.hits() - hits;
+      uint64_t search_lookups = table_.hits() + table_.misses() - lookups;
+      *telemetry_out_
+          << "{\"player\":\"negamax\",\"key\":\""
+          << packed_to_string(canonical_key(state)) << "\",\"play\":{"
+          << play_to_json(plays[best]) << "},\"depth\":" << depth
+          << ",\"score\":" << best_score << ",\"nodes\":" << nodes_
+          << ",\"seconds\":" << seconds << ",\"nodes_per_second\":"
+          << (seconds > 0 ? nodes_ / seconds : 0) << ",\"table_hit_rate\":"
+          << (search_lookups ? double(search_hits) / search_lookups : 0)
+          << ",\"table_entries\":" << table_.size() << "}" << std::endl;
+    }
+    return best;
+  }
+
+private:
+  // Searches every root play to depth and returns the index of the best,
+  // setting *score to its score.
+  int search_root(const State &state, const Plays &plays, int depth,
+                  int *score) {
+    Plays ordered(plays);
+    int keys[MAX_LEGAL_MOVES];
+    score_plays(state, &ordered, 0, keys);
+    int alpha = -INFINITE_SCORE;
+    Play best = plays[0];
+    State board(state);
+    for (int i = 0; i < ordered.size(); ++i) {
+      next_play(&ordered, keys, i);
+      Undo undo = make_play(&board, ordered[i]);
+      int value = -negamax(&board, depth - 1, -INFINITE_SCORE, -alpha, 1);
+      unmake_play(&board, ordered[i], undo);
+      if (stopped_) {
+        return 0;
+      }
+      if (value > alpha) {
+        alpha = value;
+        best = ordered[i];
+      }
+    }
+    store(state, depth, alpha, NegamaxEntry::EXACT, best, 0);
+    *score = alpha;
+    return std::find(plays.begin(), plays.end(), best) - plays.begin();
+  }
+
+  // Searches the board to depth, making and taking back plays on it in
+  // place, so that it is unchanged on return.
+  int negamax(State *board, int depth, int alpha, int beta, int ply) {
+    const State &state = *board;
+    if (!(++nodes_ & 1023) && std::chrono::steady_clock::now() >= deadline_) {
+      stopped_ = true;
+    }
+    if (stopped_) {
+      return 0;
+    }
+    if (has_immediate_win(state)) {
+      return WIN_SCORE - ply;
+    }
+    if (depth <= 0 || ply >= MAX_SEARCH_PLY) {
+      return has_legal_play(state) ? evaluate(state) : -(WIN_SCORE - ply);
+    }
+
+    const NegamaxEntry *entry = table_.find(state.hash);
+    if (entry && entry->depth >= depth) {
+      int score = from_table(entry->score, ply);
+      if (entry->bound == NegamaxEntry::EXACT ||
+          (entry->bound == NegamaxEntry::LOWER && score >= beta) ||
+          (entry->bound == NegamaxEntry::UPPER && score <= alpha)) {
+        return score;
+      }
+    }
+
+    Plays plays = get_legal_plays(state);
+    if (!plays.size()) {
+      return -(WIN_SCORE - ply);
+    }
+    int keys[MAX_LEGAL_MOVES];
+    score_plays(state, &plays, ply, keys);
+
+    const int original_alpha = alpha;
+    int best_score = -INFINITE_SCORE;
+    Play best = plays[0];
+    for (int i = 0; i < plays.size(); ++i) {
+      next_play(&plays, keys, i);
+      const Play &play = plays[i];
+      Undo undo = make_play(board, play);
+      int score = -negamax(board, depth - 1, -beta, -alpha, ply + 1);
+      unmake_play(board, play, undo);
+      if (stopped_) {
+        return 0;
+      }
+      if (score > best_score) {
+        best_score = score;
+        best = play;
+      }
+      if (score > alpha) {
+        alpha = score;
+      }
+      if (alpha >= beta) {
+        if (!(play == killers_[ply][0])) {
+          killers_[ply][1] = killers_[ply][0];
+          killers_[ply][0] = play;
+        }
+        int &history = history_[state.player][cell_index(play.end)]
+                               [cell_index(play.build)];
+        history += depth * depth;
+        if (history > MAX_HISTORY) {
+          age_history();
+        }
+        break;
+      }
+    }
+    NegamaxEntry::Bound bound = best_score <= original_alpha
+                                    ? NegamaxEntry::UPPER
+                                    : best_score >= beta ? NegamaxEntry::LOWER
+                                                         : NegamaxEntry::EXACT;
+    store(state, depth, best_score, bound, best, ply);
+    return best_score;
+  }
+
+  // Halves every history score, so that recent cutoffs count for more.
+  void age_history() {
+    for (int player = 0; player < 2; ++player) {
+      for (int end = 0; end < CELL_COUNT; ++end) {
+        for (int build = 0; build < CELL_COUNT; ++build) {
+          history_[player][end][build] /= 2;
+        }
+      }
+    }
+  }
+
+  // Gives each play an ordering key, highest first.
+  void score_plays(const State &state, Plays *plays, int ply, int *keys) {
+    const NegamaxEntry *entry = table_.find(state.hash);
+    for (int i = 0; i < plays->size(); ++i) {
+      const Play &play = (*plays)[i];
+      int end = cell_index(play.end);
+      int build = cell_index(play.build);
+      if (entry && entry->end != entry->build && entry->pawn == play.pawn &&
+          entry->end == end && entry->build == build) {
+        keys[i] = 1 << 30;
+      } else if (play == killers_[ply][0]) {
+        keys[i] = 1 << 29;
+      } else if (play == killers_[ply][1]) {
+        keys[i] = 1 << 28;
+      } else {
+        int climb = state.get_height(end) -
+                    state.get_height(state.position[state.player][play.pawn]);
+        keys[i] = (climb + MAX_HEIGHT) * MAX_HISTORY +
+                  std::min(history_[state.player][end][build], MAX_HISTORY - 1);
+      }
+    }
+  }
+
+  // Moves the remaining play with the highest key to index i. Cutoffs
+  // usually come early, so this beats sorting all of them up front.
+  static void next_play(Plays *plays, int *keys, int i) {
+    int best = i;
+    for (int j = i + 1; j < plays->size(); ++j) {
+      if (keys[j] > keys[best]) {
+        best = j;
+      }
+    }
+    std::swap((*plays)[i], (*plays)[best]);
+    std::swap(keys[i], keys[best]);
+  }
+
+  void store(const State &state, int depth, int score,
+             NegamaxEntry::Bound bound, const Play &best, int ply) {
+    NegamaxEntry *entry = table_.insert(state.hash);
+    entry->score = to_table(score, ply);
+    entry->depth = depth;
+    entry->bound = bound;
+    entry->pawn = best.pawn;
+    entry->end = cell_index(best.end);
+    entry->build = cell_index(best.build);
+  }
+
+  // Win scores count plies from the root, but the table is shared between
+  // plies, so they are stored counting from the state itself.
+  static int to_table(int score, int ply) {
+    return score >= WIN_SCORE - MAX_SEARCH_PLY
+               ? score + ply
+               : score <= -(WIN_SCORE - MAX_SEARCH_PLY) ? score - ply : score;
+  }
+
+  static int from_table(int score, int ply) {
+    return score >= WIN_SCORE - MAX_SEARCH_PLY
+               ? score - ply
+               : score <= -(WIN_SCORE - MAX_SEARCH_PLY) ? score + ply : score;
+  }
+
+  // Scores a state without searching. Pawns are better high up, with room
+  // to move, with steps up next to them and near the center.
+  static int evaluate(const State &state) {
+    Bitboard open = state.open_cells();
+    int score = 0;
+    for (int player = 0; player < 2; ++player) {
+      int pawn_scores = 0;
+      for (int pawn = 0; pawn < PAWN_COUNT; ++pawn) {
+        Position p = state.position[player][pawn];
+        int h = state.get_height(p);
+        Bitboard near = NEIGHBORS[cell_index(p)] & open;
+        const int middle = BOARD_WIDTH / 2;
+        pawn_scores +=
+            PAWN_HEIGHT_SCORE[h] +
+            MOBILITY_SCORE *
+                __builtin_popcount(near & state.cells_at_most(h + 1)) +
+            CLIMB_SCORE * __builtin_popcount(near & state.cells_at(h + 1)) +
+            CENTER_SCORE *
+                (middle -
+                 std::max(std::abs(p.x - middle), std::abs(p.y - middle)));
+        if (h == MAX_HEIGHT - 2 && (near & state.cells_at(MAX_HEIGHT - 1))) {
+          pawn_scores += THREAT_SCORE;
+        }
+      }
+      score += player == state.player ? pawn_scores : -pawn_scores;
+    }
+    return score;
+  }
+
+  TimeManager time_;
+  TranspositionTable<NegamaxEntry> table_;
+  Play killers_[MAX_SEARCH_PLY][2];
+  int history_[2][CELL_COUNT][CELL_COUNT]; // By player, end and build cell.
+  std::chrono::steady_clock::time_point deadline_;
+  int64_t nodes_;
+  bool stopped_;
+  std::ostream *telemetry_out_;
+};
+
+class HumanPlayer {
+public:
+  int select_move(const State &state, const Plays &plays) {
+    // print_state(state);
+    std::string player_label = state.player ? "b" : "a";
+    std::string expected_pawns[] = {player_label + "0", player_label + "1"};
+    int pawn;
+    Position end;
+    Position build;
+    while (true) {
+      std::string input;
+
+      // Get pawn.
+      pawn = 0;
+      while (true) {
+        std::cout << "Which pawn will you move (" << expected_pawns[0] << " or "
+                  << expected_pawns[1] << ")\n> ";
+        std::cin >> input;
+        if (input != expected_pawns[0] && input != expected_pawns[1]) {
+          std::cout << "Invalid pawn selection, please enter "
+                    << expected_pawns[0] << " or " << expected_pawns[1]
+                    << ".\n";
+          continue;
+        }
+        if (input == expected_pawns[1]) {
+          pawn = 1;
+        }
+        break;
+      }
+      bool valid_pawn = false;
+      for (int i = 0; i < plays.size(); ++i) {
+        if (plays[i].pawn == pawn) {
+          valid_pawn = true;
+          break;
+        }
+      }
+      if (!valid_pawn) {
+        std::cout << "Pawn " << expected_pawns[pawn] << " has no valid moves, "
+                  << "please select the other pawn.\n";
+        continue;
+      }
+
+      // Get end.
+      Position start = state.position[state.player][pawn];
+      while (true) {
+        std::cout << "Which direction will you move\n> ";
+        char direction;
+        std::cin >> direction;
+        end = get_new_position(start, direction);
+        if (end.x < 0) {
+          std::cout << "Invalid move direction\n";
+          continue;
+        }
+        bool valid_move = false;
+        for (int i = 0; i < plays.size(); ++i) {
+          if (plays[i].pawn == pawn && plays[i].end == end) {
+            valid_move = true;
+            break;
+          }
+        }
+        if (!valid_move) {
+          std::cout << "That move is not legal for that pawn. "
+                  "Try again.\n";
+          continue;
+        }
+        break;
+      }
+
+      // Get build.
+      while (true) {
+        std::cout << "Which direction will you build\n> ";
+        char direction;
+        std::cin >> direction;
+        build = get_new_position(end, direction);
+        if (build.x < 0) {
+          std::cout << "Invalid build direction\n";
+          continue;
+        }
+        for (int i = 0; i < plays.size(); ++i) {
+          if (plays[i].pawn == pawn && plays[i].end == end &&
+              plays[i].build == build) {
+            return i;
+          }
+        }
+        std::cout << "That build is not legal for that pawn "
+                  << "and that move. Try again.\n";
+      }
+    }
+  }
+
+private:
+  Position get_new_position(const Position &start, char entry) {
+    Position end;
+    switch (entry) {
+    case '1': // fall-through.
+    case 'z':
+      end.x = start.x - 1;
+      end.y = start.y + 1;
+      break;
+    case '2': // fall-through.
+    case 'x':
+      end.x = start.x;
+      end.y = start.y + 1;
+      break;
+    case '3': // fall-through.
+    case 'c':
+      end.x = start.x + 1;
+      end.y = start.y + 1;
+      break;
+    case '4': // fall-through.
+    case 'a':
+      end.x = start.x - 1;
+      end.y = start.y;
+      break;
+    case '6': // fall-through.
+    case 'd':
+      end.x = start.x + 1;
+      end.y = start.y;
+      break;
+    case '7': // fall-through.
+    case 'q':
+      end.x = start.x - 1;
+      end.y = start.y - 1;
+      break;
+    case '8': // fall-through.
+    case 'w':
+      end.x = start.x;
+      end.y = start.y - 1;
+      break;
+    case '9': // fall-through.
+    case 'e':
+      end.x = start.x + 1;
+      end.y = start.y - 1;
+      break;
+    default:
+      end.x = -1;
+      end.y = -1;
+    }
+    return end;
+  }
+};
+
+// Any of the players behind one interface, for code that only knows at run
+// time which players it has.
+class Player {
+public:
+  virtual ~Player() {}
+  virtual int select_move(const State &state, const Plays &plays) = 0;
+  // As ProgressLog::set_log.
+  virtual void set_log(std::ostream *out) = 0;
+};
+
+template <typename P> class PlayerOf : public Player {
+public:
+  template <typename... Args>
+  explicit PlayerOf(Args &&... args) : player_(std::forward<Args>(args)...) {}
+
+  int select_move(const State &state, const Plays &plays) override {
+    return player_.select_move(state, plays);
+  }
+
+  void set_log(std::ostream *out) override { player_.set_log(out); }
+
+  P &get() { return player_; }
+
+private:
+  P player_;
+};
+
+// Makes a single-threaded player from a spec of the form "name" or
+// "name:ms", where ms is the time per move (100 by default):
+//
+//   simple       SimplePlayer
+//   rollout      SimpleRolloutPlayer
+//   mcts         MonteCarlo with its default ClimbBiasedPolicy
+//   mcts-first   MonteCarlo with FirstPlayPolicy
+//   mcts-batch   MonteCarlo with batched leaf playouts
+//   mcts-ponder  MonteCarlo that ponders on the opponent's time
+//   mcts-rave    MonteCarlo with RAVE statistics
+//   mcts-solver  MonteCarlo that runs its endgame solver
+//   negamax      NegamaxPlayer
+//
+// Returns nullptr for an unknown name. The tree_bytes of MonteCarlo and the
+// table of NegamaxPlayer are kept small so that many can play at once.
+inline std::unique_ptr<Player> make_player(const std::string &spec,
+                                           uint64_t seed) {
+  size_t colon = spec.find(':');
+  std::string name = spec.substr(0, colon);
+  std::chrono::milliseconds time(colon == std::string::npos
+                                ? 100
+                                : atoi(spec.c_str() + colon + 1));
+  const size_t memory = size_t(32) << 20;
+  std::unique_ptr<Player> player;
+  if (name == "simple") {
+    player.reset(new PlayerOf<SimplePlayer>(seed));
+  } else if (name == "rollout") {
+    player.reset(new PlayerOf<SimpleRolloutPlayer<>>(time, seed));
+  } else if (name == "mcts") {
+    auto mcts = new PlayerOf<MonteCarlo<true>>(time, 1, memory);
+    mcts->get().set_rollout_seed(seed);
+    player.reset(mcts);
+  } else if (name == "mcts-first") {
+    player.reset(
+        new PlayerOf<MonteCarlo<true, FirstPlayPolicy>>(time, 1, memory));
+  } else if (name == "mcts-batch") {
+    auto mcts = new PlayerOf<MonteCarlo<true>>(time, 1, memory);
+    mcts->get().enable_batch_playouts(seed);
+    player.reset(mcts);
+  } else if (name == "mcts-ponder") {
+    auto mcts = new PlayerOf<MonteCarlo<true>>(time, 1, memory);
+    mcts->get().set_rollout_seed(seed);
+    mcts->get().enable_pondering();
+    player.reset(mcts);
+  } else if (name == "mcts-rave") {
+    auto mcts = new PlayerOf<MonteCarlo<true>>(time, 1, memory);
+    mcts->get().set_rollout_seed(seed);
+    mcts->get().enable_rave();
+    player.reset(mcts);
+  } else if (name == "mcts-solver") {
+    auto mcts = new PlayerOf<MonteCarlo<true>>(time, 1, memory);
+    mcts->get().set_rollout_seed(seed);
+    mcts->get().enable_solver();
+    player.reset(mcts);
+  } else if (name == "negamax") {
+    player.reset(new PlayerOf<NegamaxPlayer>(time, memory));
+  }
+  return player;
+}
+
+// Reads start states from a file of pawn positions, one state per line as
+// "x0 y0 x1 y1 x2 y2 x3 y3" for player 0's pawns and then player 1's.
+inline std::vector<State> read_starting_positions(const std::string &path) {
+  std::vector<State> states;
+  std::fstream fs(path, std::fstream::in);
+  while (true) {
+    State state = get_start_state();
+    Position p[2][PAWN_COUNT];
+    fs
+      >> p[0][0].x >> p[0][0].y
+      >> p[0][1].x >> p[0][1].y
+      >> p[1][0].x >> p[1][0].y
+      >> p[1][1].x >> p[1][1].y;
+    if (!fs) {
+      break;
+    }
+    memcpy(state.position, p, sizeof(p));
+    state.sync();
+    states.push_back(state);
+  }
+  return states;
+}
+
+} // namespace detail
+} // namespace santorini
+
+#endif // SANTORINI_H